@@ -0,0 +1,134 @@
+#include "bmp_batch_renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace
+{
+    // Job queue of one worker: the owner pops from the front, thieves take from the back
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> jobs;
+
+        bool popFront(size_t &job)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (jobs.empty())
+                return false;
+            job = jobs.front();
+            jobs.pop_front();
+            return true;
+        }
+
+        bool stealBack(size_t &job)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (jobs.empty())
+                return false;
+            job = jobs.back();
+            jobs.pop_back();
+            return true;
+        }
+    };
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+// Constructor
+BMPBatchRenderer::BMPBatchRenderer(unsigned threads)
+{
+    thread_count = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    canvases.assign(thread_count, BMPImageCreator(1, 1));
+}
+
+// Render all jobs
+BMPBatchStats BMPBatchRenderer::run(const std::vector<BMPRenderJob> &jobs)
+{
+    BMPBatchStats stats;
+    stats.job_milliseconds.assign(jobs.size(), 0.0);
+    stats.job_failed.assign(jobs.size(), 0);
+    stats.job_errors.assign(jobs.size(), std::string());
+    const auto batch_start = std::chrono::steady_clock::now();
+
+    // Deal out contiguous slices, stealing evens out the rest
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (unsigned t = 0; t < thread_count; ++t)
+    {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        queues[i * thread_count / jobs.size()]->jobs.push_back(i);
+    }
+
+    auto worker = [&](unsigned self)
+    {
+        BMPImageCreator &canvas = canvases[self];
+        size_t index;
+        while (true)
+        {
+            bool found = queues[self]->popFront(index);
+            for (unsigned k = 1; !found && k < thread_count; ++k)
+            {
+                found = queues[(self + k) % thread_count]->stealBack(index);
+            }
+            if (!found)
+                return;
+
+            const BMPRenderJob &job = jobs[index];
+            const auto job_start = std::chrono::steady_clock::now();
+
+            // A failing job is recorded and the worker moves on; an exception must not reach the thread boundary
+            try
+            {
+                canvas.reset(job.width, job.height);
+                if (job.recording)
+                    job.recording->replay(canvas);
+                if (job.draw)
+                    job.draw(canvas);
+                if (!job.filename.empty() && !canvas.saveFile(job.filename, job.format))
+                    stats.job_errors[index] = "can't write " + job.filename + (job.format == BMPFileFormat::QOI ? ".qoi" : ".bmp");
+                if (job.output)
+                    job.output(canvas);
+            }
+            catch (const std::exception &e)
+            {
+                stats.job_errors[index] = e.what();
+            }
+            catch (...)
+            {
+                stats.job_errors[index] = "unknown exception";
+            }
+            stats.job_failed[index] = !stats.job_errors[index].empty();
+
+            stats.job_milliseconds[index] = millisecondsSince(job_start);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < thread_count; ++t)
+    {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    stats.failed_jobs = static_cast<size_t>(std::count(stats.job_failed.begin(), stats.job_failed.end(), 1));
+    stats.total_milliseconds = millisecondsSince(batch_start);
+    if (stats.total_milliseconds > 0.0)
+        stats.images_per_second = jobs.size() * 1000.0 / stats.total_milliseconds;
+    return stats;
+}
@@ -0,0 +1,57 @@
+#ifndef BMP_BATCH_RENDERER_H
+#define BMP_BATCH_RENDERER_H
+
+#include "bmp_image_creator.h"
+#include "bmp_render_cache.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// One independent image: size, what to draw and where it goes
+struct BMPRenderJob
+{
+    int32_t width = 0;
+    int32_t height = 0;
+
+    // Drawing: a callback, a recorded draw list, or both (recording runs first)
+    const BMPDrawRecorder *recording = nullptr;
+    std::function<void(BMPImageCreator &)> draw;
+
+    // Output: <filename>.bmp (or .qoi) if set, and/or a callback that gets the finished canvas
+    std::string filename;
+    BMPFileFormat format = BMPFileFormat::BMP;
+    std::function<void(const BMPImageCreator &)> output;
+};
+
+// Timing and failures of one batch
+struct BMPBatchStats
+{
+    std::vector<double> job_milliseconds;  // latency per job, in job order
+    std::vector<unsigned char> job_failed; // 1 where the job failed (see job_errors); its output may be missing
+    std::vector<std::string> job_errors;   // why each failed job failed, empty for the others
+    size_t failed_jobs = 0;
+    double total_milliseconds = 0.0;       // wall time of the whole batch
+    double images_per_second = 0.0;
+};
+
+// Renders independent jobs across a work-stealing thread pool, one reused canvas per thread
+class BMPBatchRenderer
+{
+public:
+    // Constructor (0 threads = one per hardware thread)
+    explicit BMPBatchRenderer(unsigned threads = 0);
+
+    // Render all jobs, returns once every job is done
+    BMPBatchStats run(const std::vector<BMPRenderJob> &jobs);
+
+    unsigned getThreadCount() const { return thread_count; }
+
+private:
+    unsigned thread_count;
+    std::vector<BMPImageCreator> canvases; // one per worker, kept between runs
+};
+
+#endif // BMP_BATCH_RENDERER_H
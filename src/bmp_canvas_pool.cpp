@@ -0,0 +1,74 @@
+#include "bmp_canvas_pool.h"
+
+#include <utility>
+
+// Hand a canvas back to its pool (or delete it if it has none)
+template <typename Format>
+void BasicBMPCanvasPool<Format>::Releaser::operator()(Canvas *canvas) const
+{
+    if (pool)
+        pool->release(canvas);
+    else
+        delete canvas;
+}
+
+// Constructor
+template <typename Format>
+BasicBMPCanvasPool<Format>::BasicBMPCanvasPool(size_t max_idle1) : max_idle(max_idle1)
+{
+    idle.reserve(max_idle);
+}
+
+// Get a white canvas of the given size, preferring one that already has these dimensions
+template <typename Format>
+typename BasicBMPCanvasPool<Format>::Handle BasicBMPCanvasPool<Format>::acquire(int32_t width, int32_t height)
+{
+    std::unique_ptr<Canvas> canvas;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty())
+        {
+            size_t pick = idle.size() - 1;
+            for (size_t i = 0; i < idle.size(); ++i)
+            {
+                if (idle[i]->getWidth() == width && idle[i]->getHeight() == height)
+                {
+                    pick = i;
+                    break;
+                }
+            }
+            std::swap(idle[pick], idle.back());
+            canvas = std::move(idle.back());
+            idle.pop_back();
+        }
+    }
+
+    if (canvas)
+        canvas->reset(width, height);
+    else
+        canvas = std::make_unique<Canvas>(width, height);
+
+    return Handle(canvas.release(), Releaser(this));
+}
+
+// Keep a released canvas for reuse, dropping it if the pool is full
+template <typename Format>
+void BasicBMPCanvasPool<Format>::release(Canvas *canvas)
+{
+    std::unique_ptr<Canvas> owned(canvas);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < max_idle)
+        idle.push_back(std::move(owned));
+}
+
+// Number of canvases waiting for reuse
+template <typename Format>
+size_t BasicBMPCanvasPool<Format>::idleCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
+
+template class BasicBMPCanvasPool<BGR24>;
+template class BasicBMPCanvasPool<BGRA32>;
+template class BasicBMPCanvasPool<Gray8>;
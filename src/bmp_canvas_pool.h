@@ -0,0 +1,59 @@
+#ifndef BMP_CANVAS_POOL_H
+#define BMP_CANVAS_POOL_H
+
+#include "bmp_image_creator.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Thread-safe pool of canvases that are reset instead of reallocated.
+// Handles return their canvas to the pool when destroyed, so the pool must outlive them.
+template <typename Format>
+class BasicBMPCanvasPool
+{
+public:
+    using Canvas = BasicBMPImageCreator<Format>;
+
+    class Releaser
+    {
+    public:
+        Releaser() = default;
+        explicit Releaser(BasicBMPCanvasPool *pool) : pool(pool) {}
+        void operator()(Canvas *canvas) const;
+
+    private:
+        BasicBMPCanvasPool *pool = nullptr;
+    };
+
+    using Handle = std::unique_ptr<Canvas, Releaser>;
+
+    // Constructor (max_idle = how many released canvases are kept around)
+    explicit BasicBMPCanvasPool(size_t max_idle = 64);
+
+    BasicBMPCanvasPool(const BasicBMPCanvasPool &) = delete;
+    BasicBMPCanvasPool &operator=(const BasicBMPCanvasPool &) = delete;
+
+    // Get a white canvas of the given size, reusing a released one if possible (throws std::length_error like reset)
+    Handle acquire(int32_t width, int32_t height);
+
+    // Number of canvases waiting for reuse
+    size_t idleCount() const;
+
+private:
+    size_t max_idle;
+    std::vector<std::unique_ptr<Canvas>> idle;
+    mutable std::mutex mutex;
+
+    void release(Canvas *canvas);
+};
+
+using BMPCanvasPool = BasicBMPCanvasPool<BGR24>;
+
+extern template class BasicBMPCanvasPool<BGR24>;
+extern template class BasicBMPCanvasPool<BGRA32>;
+extern template class BasicBMPCanvasPool<Gray8>;
+
+#endif // BMP_CANVAS_POOL_H
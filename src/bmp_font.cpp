@@ -0,0 +1,472 @@
+#include "bmp_font.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+static constexpr uint32_t replacement_character = 0xFFFD;
+
+// Read a whole file (false if it can't be opened)
+static bool readFile(const std::string &filename, std::vector<uint8_t> &data)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Little-endian 32-bit field
+static uint32_t readU32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+// Value of one hex digit (-1 if it isn't one)
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Load a font once per path and share it
+std::shared_ptr<const BMPFont> BMPFont::load(const std::string &filename)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const BMPFont>> loaded;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = loaded.find(filename);
+    if (it != loaded.end())
+    {
+        return it->second;
+    }
+
+    auto font = std::make_shared<BMPFont>();
+    if (!font->loadFile(filename))
+    {
+        return nullptr;
+    }
+    loaded[filename] = font;
+    return font;
+}
+
+// Empty atlas with the given metrics
+void BMPFont::clear(int height, int spacing1)
+{
+    glyph_height = height;
+    spacing = spacing1;
+    pages.clear();
+    glyphs.clear();
+    bits.clear();
+}
+
+// Find or create the slot of a codepoint
+BMPFont::Glyph *BMPFont::addGlyph(uint32_t c)
+{
+    if (c > max_codepoint)
+        return nullptr;
+
+    const uint32_t page = c / page_size;
+    if (page >= pages.size())
+        pages.resize(page + 1, -1);
+    if (pages[page] < 0)
+    {
+        pages[page] = static_cast<int32_t>(glyphs.size());
+        glyphs.resize(glyphs.size() + page_size);
+    }
+    return &glyphs[pages[page] + c % page_size];
+}
+
+// Detect the format from the first bytes of the file
+bool BMPFont::loadFile(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    unsigned char magic[9] = {};
+    file.read(reinterpret_cast<char *>(magic), sizeof(magic));
+    file.close();
+
+    if (magic[0] == 0x72 && magic[1] == 0xb5 && magic[2] == 0x4a && magic[3] == 0x86)
+        return loadPSF2(filename);
+    if (std::memcmp(magic, "STARTFONT", 9) == 0)
+        return loadBDF(filename);
+    return loadFnt(filename);
+}
+
+// Hash everything drawText reads, field by field so padding never leaks in
+uint64_t BMPFont::contentHash() const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    add(&glyph_height, sizeof(glyph_height));
+    add(&spacing, sizeof(spacing));
+    add(pages.data(), pages.size() * sizeof(int32_t));
+    for (const Glyph &glyph : glyphs)
+    {
+        add(&glyph.offset, sizeof(glyph.offset));
+        add(&glyph.width, sizeof(glyph.width));
+        add(&glyph.advance, sizeof(glyph.advance));
+        add(&glyph.left, sizeof(glyph.left));
+        add(&glyph.present, sizeof(glyph.present));
+    }
+    add(bits.data(), bits.size());
+    return hash;
+}
+
+// Decode one UTF-8 sequence, rejecting overlong forms, surrogates and values past U+10FFFF
+uint32_t BMPFont::decodeUTF8(std::string_view text, size_t &pos)
+{
+    const unsigned char lead = static_cast<unsigned char>(text[pos++]);
+    if (lead < 0x80)
+        return lead;
+
+    int extra;
+    uint32_t c;
+    uint32_t smallest;
+    if ((lead & 0xE0) == 0xC0)
+    {
+        extra = 1;
+        c = lead & 0x1F;
+        smallest = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        extra = 2;
+        c = lead & 0x0F;
+        smallest = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        extra = 3;
+        c = lead & 0x07;
+        smallest = 0x10000;
+    }
+    else
+    {
+        return replacement_character;
+    }
+
+    if (pos + extra > text.size())
+        return replacement_character;
+    for (int i = 0; i < extra; ++i)
+    {
+        const unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80)
+            return replacement_character;
+        c = c << 6 | (next & 0x3F);
+    }
+    if (c < smallest || c > max_codepoint || (c >= 0xD800 && c <= 0xDFFF))
+        return replacement_character;
+
+    pos += extra;
+    return c;
+}
+
+// Load font from .fnt file, dropping empty columns from every glyph
+bool BMPFont::loadFnt(const std::string &filename)
+{
+    constexpr int char_width = 8;
+    constexpr int char_height = 8;
+    constexpr int char_quantity = 128;
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint8_t raw[char_quantity][char_height] = {};
+    file.read(reinterpret_cast<char *>(raw), sizeof(raw));
+
+    clear(char_height, 1);
+
+    for (int c = 0; c < char_quantity; ++c)
+    {
+        // Columns that survive cropping (the space keeps only its last 3 columns)
+        std::vector<int> kept_columns;
+        for (int cx = 0; cx < char_width; ++cx)
+        {
+            bool empty = true;
+            for (int cy = 0; cy < char_height; ++cy)
+            {
+                if ((raw[c][cy] >> (7 - cx)) & 1)
+                {
+                    empty = false;
+                    break;
+                }
+            }
+            if (c == 32 ? cx >= 5 : !empty)
+            {
+                kept_columns.push_back(cx);
+            }
+        }
+
+        Glyph &glyph = *addGlyph(c);
+        glyph.offset = static_cast<uint32_t>(bits.size());
+        glyph.width = static_cast<uint16_t>(kept_columns.size());
+        glyph.advance = glyph.width;
+        glyph.present = true;
+
+        const size_t stride = (glyph.width + 7) / 8;
+        bits.resize(bits.size() + stride * char_height, 0);
+        for (int cy = 0; cy < char_height; ++cy)
+        {
+            for (int x = 0; x < glyph.width; ++x)
+            {
+                if ((raw[c][cy] >> (7 - kept_columns[x])) & 1)
+                {
+                    bits[glyph.offset + cy * stride + x / 8] |= static_cast<uint8_t>(0x80 >> (x % 8));
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Load a PSF2 font: glyph bitmaps already use the atlas layout, so they are copied as-is
+bool BMPFont::loadPSF2(const std::string &filename)
+{
+    constexpr size_t header_size = 32;
+    constexpr uint32_t has_unicode_table = 1;
+
+    std::vector<uint8_t> data;
+    if (!readFile(filename, data) || data.size() < header_size)
+        return false;
+    if (data[0] != 0x72 || data[1] != 0xb5 || data[2] != 0x4a || data[3] != 0x86)
+        return false;
+
+    const uint32_t offset = readU32(&data[8]);
+    const uint32_t flags = readU32(&data[12]);
+    const uint32_t count = readU32(&data[16]);
+    const uint32_t glyph_size = readU32(&data[20]);
+    const uint32_t height = readU32(&data[24]);
+    const uint32_t width = readU32(&data[28]);
+
+    const uint64_t stride = (static_cast<uint64_t>(width) + 7) / 8;
+    const uint64_t bitmaps_end = offset + static_cast<uint64_t>(count) * glyph_size;
+    if (width == 0 || width > UINT16_MAX || height == 0 || height > UINT16_MAX || offset < header_size ||
+        glyph_size < stride * height || bitmaps_end > data.size() || bitmaps_end > UINT32_MAX)
+        return false;
+
+    clear(static_cast<int>(height), 0);
+
+    // Copy the bitmaps once; several codepoints may share one of them
+    const size_t bitmap_size = static_cast<size_t>(stride * height);
+    bits.resize(static_cast<size_t>(count) * bitmap_size);
+    for (uint32_t i = 0; i < count; ++i)
+        std::memcpy(bits.data() + i * bitmap_size, data.data() + offset + static_cast<size_t>(i) * glyph_size, bitmap_size);
+
+    auto map = [&](uint32_t c, uint32_t index)
+    {
+        Glyph *glyph = addGlyph(c);
+        if (glyph && !glyph->present)
+        {
+            glyph->offset = static_cast<uint32_t>(index * bitmap_size);
+            glyph->width = static_cast<uint16_t>(width);
+            glyph->advance = glyph->width;
+            glyph->present = true;
+        }
+    };
+
+    if (!(flags & has_unicode_table))
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            map(i, i);
+        return true;
+    }
+
+    // Unicode table: per glyph, UTF-8 codepoints, optional 0xFE-prefixed combining sequences, then 0xFF
+    const std::string_view table(reinterpret_cast<const char *>(data.data() + bitmaps_end), data.size() - static_cast<size_t>(bitmaps_end));
+    size_t pos = 0;
+    for (uint32_t i = 0; i < count && pos < table.size(); ++i)
+    {
+        bool sequence = false;
+        while (pos < table.size())
+        {
+            const unsigned char byte = static_cast<unsigned char>(table[pos]);
+            if (byte == 0xFF)
+            {
+                ++pos;
+                break;
+            }
+            if (byte == 0xFE)
+            {
+                // Multi-codepoint sequences can't be drawn glyph by glyph, skip them
+                sequence = true;
+                ++pos;
+                continue;
+            }
+
+            const uint32_t c = decodeUTF8(table, pos);
+            if (!sequence && c != replacement_character)
+                map(c, i);
+        }
+    }
+    return true;
+}
+
+// Load a BDF font: every glyph is drawn into a cell spanning the font ascent and descent, wide enough for both
+// its advance and its bounding box (which may start left of the pen or end past the advance)
+bool BMPFont::loadBDF(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+        return false;
+
+    struct PendingGlyph
+    {
+        int32_t encoding = -1;
+        int advance = -1;
+        int box_width = 0;
+        int box_height = 0;
+        int box_x = 0;
+        int box_y = 0;
+        std::vector<std::string> rows;
+    };
+
+    int ascent = -1;
+    int descent = -1;
+    int bounds_height = 0;
+    int bounds_y = 0;
+    std::vector<PendingGlyph> pending;
+
+    // Glyph placement needs the font metrics, which may follow the first glyphs' headers, so parse first
+    std::string line;
+    PendingGlyph current;
+    bool in_char = false;
+    int bitmap_rows_left = -1;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (bitmap_rows_left > 0)
+        {
+            current.rows.push_back(line);
+            --bitmap_rows_left;
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string keyword;
+        fields >> keyword;
+
+        if (keyword == "FONTBOUNDINGBOX")
+        {
+            int bounds_width = 0;
+            int bounds_x = 0;
+            fields >> bounds_width >> bounds_height >> bounds_x >> bounds_y;
+        }
+        else if (keyword == "FONT_ASCENT")
+        {
+            fields >> ascent;
+        }
+        else if (keyword == "FONT_DESCENT")
+        {
+            fields >> descent;
+        }
+        else if (keyword == "STARTCHAR")
+        {
+            current = PendingGlyph();
+            in_char = true;
+            bitmap_rows_left = -1;
+        }
+        else if (!in_char)
+        {
+            continue;
+        }
+        else if (keyword == "ENCODING")
+        {
+            fields >> current.encoding;
+        }
+        else if (keyword == "DWIDTH")
+        {
+            fields >> current.advance;
+        }
+        else if (keyword == "BBX")
+        {
+            fields >> current.box_width >> current.box_height >> current.box_x >> current.box_y;
+        }
+        else if (keyword == "BITMAP")
+        {
+            bitmap_rows_left = std::max(current.box_height, 0);
+        }
+        else if (keyword == "ENDCHAR")
+        {
+            if (current.encoding >= 0)
+                pending.push_back(std::move(current));
+            in_char = false;
+            bitmap_rows_left = -1;
+        }
+    }
+
+    if (ascent < 0)
+        ascent = bounds_height + bounds_y;
+    if (descent < 0)
+        descent = -bounds_y;
+    const int height = ascent + descent;
+    if (height <= 0 || height > UINT16_MAX)
+        return false;
+
+    clear(height, 0);
+    for (const PendingGlyph &source : pending)
+    {
+        Glyph *glyph = addGlyph(static_cast<uint32_t>(source.encoding));
+        if (!glyph || glyph->present)
+            continue;
+
+        const int box_width = std::clamp(source.box_width, 0, static_cast<int>(UINT16_MAX));
+        const int box_x = std::clamp(source.box_x, static_cast<int>(INT16_MIN), static_cast<int>(INT16_MAX));
+        const int advance = std::clamp(source.advance >= 0 ? source.advance : box_x + box_width, 0, static_cast<int>(UINT16_MAX));
+        const int left = std::min(box_x, 0);
+        const int width = std::min(std::max(advance, box_x + box_width) - left, static_cast<int>(UINT16_MAX));
+        glyph->offset = static_cast<uint32_t>(bits.size());
+        glyph->width = static_cast<uint16_t>(width);
+        glyph->advance = static_cast<uint16_t>(advance);
+        glyph->left = static_cast<int16_t>(left);
+        glyph->present = true;
+
+        const size_t stride = (width + 7) / 8;
+        bits.resize(bits.size() + stride * height, 0);
+
+        // Row 0 of the box sits box_height + box_y above the baseline
+        const int top = ascent - (source.box_y + source.box_height);
+        for (size_t i = 0; i < source.rows.size(); ++i)
+        {
+            const int cy = top + static_cast<int>(i);
+            if (cy < 0 || cy >= height)
+                continue;
+
+            const std::string &hex = source.rows[i];
+            for (int j = 0; j < box_width && static_cast<size_t>(j / 4) < hex.size(); ++j)
+            {
+                const int nibble = hexDigit(hex[j / 4]);
+                const int cx = box_x - left + j;
+                if (nibble < 0 || cx < 0 || cx >= width || !((nibble >> (3 - j % 4)) & 1))
+                    continue;
+                bits[glyph->offset + cy * stride + cx / 8] |= static_cast<uint8_t>(0x80 >> (cx % 8));
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef BMP_FONT_H
+#define BMP_FONT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Bitmap font shared between canvases: glyphs live in one flat packed-bit atlas, looked up by Unicode codepoint
+class BMPFont
+{
+public:
+    struct Glyph
+    {
+        uint32_t offset = 0;  // byte offset into bits
+        uint16_t width = 0;   // bitmap width in pixels (cropped for .fnt, the BDF bounding box and advance combined)
+        uint16_t advance = 0; // pen movement after the glyph, before spacing
+        int16_t left = 0;     // x of bitmap column 0 relative to the pen (negative for BDF glyphs reaching left)
+        bool present = false;
+    };
+
+private:
+    // Codepoints are split into pages of 256 so lookup is two array reads
+    static constexpr uint32_t page_size = 256;
+    static constexpr uint32_t max_codepoint = 0x10FFFF;
+
+    // Font variables
+    int glyph_height = 0;
+    int spacing = 0;            // blank columns after each glyph and rows after each line
+    std::vector<int32_t> pages; // codepoint / page_size -> index of the page's first glyph, -1 if the page is empty
+    std::vector<Glyph> glyphs;
+    std::vector<uint8_t> bits; // each glyph is row-major, (width + 7) / 8 bytes per row, MSB first
+
+    // Start over with an empty atlas
+    void clear(int height, int spacing);
+
+    // Glyph slot for a codepoint, allocating its page (nullptr past U+10FFFF)
+    Glyph *addGlyph(uint32_t c);
+
+public:
+    // Load a font once per path and share it (nullptr if the file can't be read)
+    static std::shared_ptr<const BMPFont> load(const std::string &filename);
+
+    // Font loaders: loadFile picks the format from the file contents
+    bool loadFile(const std::string &filename);
+    bool loadFnt(const std::string &filename);  // cropped 8x8, 128-glyph .fnt
+    bool loadPSF2(const std::string &filename); // PC Screen Font 2 (.psf/.psfu), any size, optional Unicode table
+    bool loadBDF(const std::string &filename);  // X11 Glyph Bitmap Distribution Format (.bdf)
+
+    // Decode the UTF-8 codepoint at pos and advance past it (U+FFFD for malformed input)
+    static uint32_t decodeUTF8(std::string_view text, size_t &pos);
+
+    // FNV-1a hash of the metrics and glyph atlas: equal hashes draw the same text
+    uint64_t contentHash() const;
+
+    // Glyph access
+    int getHeight() const { return glyph_height; }
+    int getSpacing() const { return spacing; }
+    const Glyph *findGlyph(uint32_t c) const
+    {
+        const uint32_t page = c / page_size;
+        if (page >= pages.size() || pages[page] < 0)
+            return nullptr;
+        const Glyph &glyph = glyphs[pages[page] + c % page_size];
+        return glyph.present ? &glyph : nullptr;
+    }
+    const uint8_t *glyphRow(const Glyph &glyph, int y) const
+    {
+        return bits.data() + glyph.offset + static_cast<size_t>(y) * ((glyph.width + 7) / 8);
+    }
+    bool hasGlyph(uint32_t c) const { return findGlyph(c) != nullptr; }
+    int glyphWidth(uint32_t c) const
+    {
+        const Glyph *glyph = findGlyph(c);
+        return glyph ? glyph->width : 0;
+    }
+    int glyphAdvance(uint32_t c) const
+    {
+        const Glyph *glyph = findGlyph(c);
+        return glyph ? glyph->advance : 0;
+    }
+    bool glyphPixel(uint32_t c, int x, int y) const
+    {
+        const Glyph *glyph = findGlyph(c);
+        return glyph && (glyphRow(*glyph, y)[x / 8] >> (7 - x % 8)) & 1;
+    }
+};
+
+#endif // BMP_FONT_H
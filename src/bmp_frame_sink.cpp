@@ -0,0 +1,232 @@
+#include "bmp_frame_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Full-range BT.601 coefficients in 16-bit fixed point
+static constexpr int32_t y_r = 19595;
+static constexpr int32_t y_g = 38470;
+static constexpr int32_t y_b = 7471;
+static constexpr int32_t u_r = -11059;
+static constexpr int32_t u_g = -21709;
+static constexpr int32_t u_b = 32768;
+static constexpr int32_t v_r = 32768;
+static constexpr int32_t v_g = -27439;
+static constexpr int32_t v_b = -5329;
+
+// Chroma from the sum of four RGB samples (hence the shift by 18), offset by 128 and rounded
+static unsigned char chroma(int32_t sum_r, int32_t sum_g, int32_t sum_b, int32_t cr, int32_t cg, int32_t cb)
+{
+    const int32_t value = (cr * sum_r + cg * sum_g + cb * sum_b + (128 << 18) + (1 << 17)) >> 18;
+    return static_cast<unsigned char>(std::min(value, 255));
+}
+
+// Constructor
+BMPFrameSink::BMPFrameSink(int fd, BMPFrameFormat format, int frame_rate_num, int frame_rate_den)
+    : fd(fd), format(format), frame_rate_num(std::max(frame_rate_num, 1)), frame_rate_den(std::max(frame_rate_den, 1))
+{
+}
+
+// Convert two RGB rows into luma rows and one row of 2x2-averaged chroma
+void BMPFrameSink::convertRows(const unsigned char *top, const unsigned char *bottom, unsigned char *y_top, unsigned char *y_bottom, unsigned char *u, unsigned char *v) const
+{
+    // Plain strided loops over the rows so the compiler can vectorize them
+    for (int32_t x = 0; x < width; ++x)
+    {
+        const unsigned char *p = top + static_cast<size_t>(x) * 3;
+        y_top[x] = static_cast<unsigned char>((y_r * p[0] + y_g * p[1] + y_b * p[2] + 32768) >> 16);
+    }
+    if (y_bottom)
+    {
+        for (int32_t x = 0; x < width; ++x)
+        {
+            const unsigned char *p = bottom + static_cast<size_t>(x) * 3;
+            y_bottom[x] = static_cast<unsigned char>((y_r * p[0] + y_g * p[1] + y_b * p[2] + 32768) >> 16);
+        }
+    }
+
+    const int32_t pairs = width / 2;
+    for (int32_t cx = 0; cx < pairs; ++cx)
+    {
+        const unsigned char *a = top + static_cast<size_t>(cx) * 6;
+        const unsigned char *b = bottom + static_cast<size_t>(cx) * 6;
+        const int32_t sum_r = a[0] + a[3] + b[0] + b[3];
+        const int32_t sum_g = a[1] + a[4] + b[1] + b[4];
+        const int32_t sum_b = a[2] + a[5] + b[2] + b[5];
+        u[cx] = chroma(sum_r, sum_g, sum_b, u_r, u_g, u_b);
+        v[cx] = chroma(sum_r, sum_g, sum_b, v_r, v_g, v_b);
+    }
+
+    // Odd width: the last column stands in for its missing neighbour
+    if (width % 2 != 0)
+    {
+        const unsigned char *a = top + static_cast<size_t>(pairs) * 6;
+        const unsigned char *b = bottom + static_cast<size_t>(pairs) * 6;
+        const int32_t sum_r = 2 * (a[0] + b[0]);
+        const int32_t sum_g = 2 * (a[1] + b[1]);
+        const int32_t sum_b = 2 * (a[2] + b[2]);
+        u[pairs] = chroma(sum_r, sum_g, sum_b, u_r, u_g, u_b);
+        v[pairs] = chroma(sum_r, sum_g, sum_b, v_r, v_g, v_b);
+    }
+}
+
+#ifdef _WIN32
+// No writev() here: write the pieces one after another
+bool BMPFrameSink::writeAll(const unsigned char *const *data, const size_t *sizes, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        size_t done = 0;
+        while (done < sizes[i])
+        {
+            const unsigned int length = static_cast<unsigned int>(std::min<size_t>(sizes[i] - done, 1u << 30));
+            const int written = ::_write(fd, data[i] + done, length);
+            if (written <= 0)
+            {
+                return false;
+            }
+            done += static_cast<size_t>(written);
+        }
+    }
+    return true;
+}
+#else
+// Write every piece, continuing after partial writes
+bool BMPFrameSink::writeAll(const unsigned char *const *data, const size_t *sizes, int count)
+{
+    iovec pieces[4];
+    int used = 0;
+    for (int i = 0; i < count && used < 4; ++i)
+    {
+        if (sizes[i] > 0)
+        {
+            pieces[used].iov_base = const_cast<unsigned char *>(data[i]);
+            pieces[used].iov_len = sizes[i];
+            ++used;
+        }
+    }
+
+    int first = 0;
+    while (first < used)
+    {
+        const ssize_t written = ::writev(fd, pieces + first, used - first);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        size_t left = static_cast<size_t>(written);
+        while (first < used && left >= pieces[first].iov_len)
+        {
+            left -= pieces[first].iov_len;
+            ++first;
+        }
+        if (first < used)
+        {
+            pieces[first].iov_base = static_cast<unsigned char *>(pieces[first].iov_base) + left;
+            pieces[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+#endif
+
+// Convert a canvas into the frame buffer and send it
+template <typename Format>
+bool BMPFrameSink::writeFrame(const BasicBMPImageCreator<Format> &canvas)
+{
+    if (error)
+    {
+        return false;
+    }
+
+    // The first frame fixes the stream geometry
+    if (frame_count == 0)
+    {
+        width = canvas.getWidth();
+        height = canvas.getHeight();
+
+        const size_t pixel_count = static_cast<size_t>(width) * height;
+        if (format == BMPFrameFormat::Y4M)
+        {
+            const size_t chroma_size = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+            frame.resize(pixel_count + 2 * chroma_size);
+            rgb_rows.resize(static_cast<size_t>(width) * 3 * 2);
+            stream_header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) +
+                            " F" + std::to_string(frame_rate_num) + ":" + std::to_string(frame_rate_den) +
+                            " Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+        }
+        else
+        {
+            frame.resize(pixel_count * 3);
+        }
+    }
+    else if (canvas.getWidth() != width || canvas.getHeight() != height)
+    {
+        return false;
+    }
+
+    const size_t row_bytes = static_cast<size_t>(width) * 3;
+    if (format == BMPFrameFormat::RGB24)
+    {
+        for (int32_t y = 0; y < height; ++y)
+            canvas.readRowRGB(y, frame.data() + y * row_bytes);
+    }
+    else if (format == BMPFrameFormat::BGR24)
+    {
+        for (int32_t y = 0; y < height; ++y)
+            canvas.readRowBGR(y, frame.data() + y * row_bytes);
+    }
+    else
+    {
+        const size_t chroma_width = static_cast<size_t>((width + 1) / 2);
+        const size_t chroma_size = chroma_width * ((height + 1) / 2);
+        unsigned char *plane_y = frame.data();
+        unsigned char *plane_u = plane_y + static_cast<size_t>(width) * height;
+        unsigned char *plane_v = plane_u + chroma_size;
+        unsigned char *top = rgb_rows.data();
+        unsigned char *bottom = top + row_bytes;
+
+        for (int32_t y = 0; y < height; y += 2)
+        {
+            const bool pair = y + 1 < height;
+            canvas.readRowRGB(y, top);
+            if (pair)
+                canvas.readRowRGB(y + 1, bottom);
+
+            const size_t chroma_row = static_cast<size_t>(y / 2) * chroma_width;
+            convertRows(top, pair ? bottom : top, plane_y + static_cast<size_t>(y) * width,
+                        pair ? plane_y + static_cast<size_t>(y + 1) * width : nullptr,
+                        plane_u + chroma_row, plane_v + chroma_row);
+        }
+    }
+
+    // Y4M: stream header before the first frame, a FRAME marker before each one
+    static const unsigned char frame_marker[] = {'F', 'R', 'A', 'M', 'E', '\n'};
+    const bool y4m = format == BMPFrameFormat::Y4M;
+    const unsigned char *data[3] = {reinterpret_cast<const unsigned char *>(stream_header.data()), frame_marker, frame.data()};
+    const size_t sizes[3] = {y4m && frame_count == 0 ? stream_header.size() : 0, y4m ? sizeof(frame_marker) : 0, frame.size()};
+
+    if (!writeAll(data, sizes, 3))
+    {
+        error = true;
+        return false;
+    }
+    ++frame_count;
+    return true;
+}
+
+template bool BMPFrameSink::writeFrame<BGR24>(const BasicBMPImageCreator<BGR24> &);
+template bool BMPFrameSink::writeFrame<BGRA32>(const BasicBMPImageCreator<BGRA32> &);
+template bool BMPFrameSink::writeFrame<Gray8>(const BasicBMPImageCreator<Gray8> &);
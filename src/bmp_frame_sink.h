@@ -0,0 +1,69 @@
+#ifndef BMP_FRAME_SINK_H
+#define BMP_FRAME_SINK_H
+
+#include "bmp_image_creator.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Layout of the frames written by BMPFrameSink
+enum class BMPFrameFormat
+{
+    RGB24, // raw packed RGB, top-down rows (e.g. ffmpeg -f rawvideo -pix_fmt rgb24)
+    BGR24, // raw packed BGR, top-down rows (-pix_fmt bgr24)
+    Y4M    // YUV4MPEG2 stream, full-range BT.601 4:2:0 (C420jpeg, tagged XCOLORRANGE=FULL so readers don't assume 16-235)
+};
+
+// Writes successive canvases as video frames to a file descriptor (stdout, a pipe, a FIFO, a file).
+// One frame buffer is reused for the whole stream and each frame goes out with a single writev()
+// (plain _write() calls on Windows).
+// Every frame must have the size of the first one. The descriptor is not closed by the sink.
+class BMPFrameSink
+{
+public:
+    // Constructor (frame_rate_num / frame_rate_den is only used for the Y4M header)
+    explicit BMPFrameSink(int fd, BMPFrameFormat format = BMPFrameFormat::RGB24, int frame_rate_num = 30, int frame_rate_den = 1);
+
+    BMPFrameSink(const BMPFrameSink &) = delete;
+    BMPFrameSink &operator=(const BMPFrameSink &) = delete;
+
+    // Write one frame, returns false on a size mismatch or a write error (after which every call fails)
+    template <typename Format>
+    bool writeFrame(const BasicBMPImageCreator<Format> &canvas);
+
+    // Frames written so far, and whether a write has failed
+    uint64_t getFrameCount() const { return frame_count; }
+    bool failed() const { return error; }
+
+private:
+    int fd;
+    BMPFrameFormat format;
+    int frame_rate_num;
+    int frame_rate_den;
+
+    int32_t width = 0;
+    int32_t height = 0;
+    uint64_t frame_count = 0;
+    bool error = false;
+
+    // Stream header (Y4M, sent with the first frame) and the reused frame buffer
+    std::string stream_header;
+    std::vector<unsigned char> frame;
+
+    // Y4M scratch: two RGB rows per chroma row
+    std::vector<unsigned char> rgb_rows;
+
+    // Convert a pair of RGB rows (the second may repeat the first) into Y, U and V planes
+    void convertRows(const unsigned char *top, const unsigned char *bottom, unsigned char *y_top, unsigned char *y_bottom, unsigned char *u, unsigned char *v) const;
+
+    // writev() all pieces, retrying after partial writes and EINTR
+    bool writeAll(const unsigned char *const *data, const size_t *sizes, int count);
+};
+
+extern template bool BMPFrameSink::writeFrame<BGR24>(const BasicBMPImageCreator<BGR24> &);
+extern template bool BMPFrameSink::writeFrame<BGRA32>(const BasicBMPImageCreator<BGRA32> &);
+extern template bool BMPFrameSink::writeFrame<Gray8>(const BasicBMPImageCreator<Gray8> &);
+
+#endif // BMP_FRAME_SINK_H
@@ -3,12 +3,473 @@
 #include <fstream>
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Store a 32-bit header field in little-endian byte order
+static void writeLittleEndian32(unsigned char *p, uint32_t value)
+{
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+    p[2] = static_cast<unsigned char>(value >> 16);
+    p[3] = static_cast<unsigned char>(value >> 24);
+}
+
+// Integer square root (floor)
+static uint64_t isqrt64(uint64_t value)
+{
+    uint64_t result = 0;
+    uint64_t bit = uint64_t(1) << 62;
+    while (bit > value)
+        bit >>= 2;
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+// floor(sqrt(value) * 256) without shifting value into overflow: the 8 fraction bits are found from the
+// remainder, since (256s + f)^2 <= 65536 * value  <=>  512sf + f^2 <= 65536 * (value - s^2)
+static uint64_t isqrt64Fixed8(uint64_t value)
+{
+    if (value < (uint64_t(1) << 48))
+        return isqrt64(value << 16);
+
+    const uint64_t root = isqrt64(value);
+    const uint64_t scaled_remainder = (value - root * root) << 16;
+    uint64_t fraction = 0;
+    for (uint64_t bit = 128; bit != 0; bit >>= 1)
+    {
+        const uint64_t candidate = fraction | bit;
+        if (512 * root * candidate + candidate * candidate <= scaled_remainder)
+            fraction = candidate;
+    }
+    return (root << 8) | fraction;
+}
+
+// Offsets d >= 0 for which center + d or center - d lies in [0, size): always one interval [first, last]
+static void visibleOffsets(int64_t center, int32_t size, int64_t &first, int64_t &last)
+{
+    if (center < 0)
+    {
+        first = -center;
+        last = size - 1 - center;
+    }
+    else if (center >= size)
+    {
+        first = center - size + 1;
+        last = center;
+    }
+    else
+    {
+        first = 0;
+        last = std::max<int64_t>(center, size - 1 - center);
+    }
+}
+
+// Split [0, total) into up to threads contiguous bands and run them in parallel (the caller runs the first)
+static void parallelBands(int64_t total, unsigned threads, const std::function<void(int64_t, int64_t)> &band)
+{
+    const unsigned band_count = static_cast<unsigned>(std::max<int64_t>(1, std::min<int64_t>(threads, total)));
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < band_count; ++i)
+    {
+        workers.emplace_back(band, total * i / band_count, total * (i + 1) / band_count);
+    }
+    band(0, total / band_count);
+    for (auto &worker : workers)
+        worker.join();
+}
+
+// Resampling weights for one axis: destination i reads source[start .. start + count) with weights summing to 4096
+struct ResampleTaps
+{
+    std::vector<int32_t> start;
+    std::vector<int32_t> count;
+    std::vector<uint32_t> offset;
+    std::vector<uint32_t> weights;
+};
+
+static constexpr uint32_t resample_one = 4096;
+
+static ResampleTaps buildResampleTaps(int32_t source_size, int32_t dest_size, BMPResampleFilter filter)
+{
+    ResampleTaps taps;
+    const double scale = static_cast<double>(source_size) / dest_size;
+    std::vector<double> raw;
+
+    for (int32_t i = 0; i < dest_size; ++i)
+    {
+        int32_t first = 0;
+        raw.clear();
+        if (filter == BMPResampleFilter::Nearest)
+        {
+            first = std::min(static_cast<int32_t>((i + 0.5) * scale), source_size - 1);
+            raw.push_back(1.0);
+        }
+        else if (filter == BMPResampleFilter::Bilinear || scale <= 1.0)
+        {
+            // Area averaging only differs from bilinear when shrinking
+            const double center = std::clamp((i + 0.5) * scale - 0.5, 0.0, static_cast<double>(source_size - 1));
+            first = std::min(static_cast<int32_t>(center), std::max(source_size - 2, 0));
+            const double frac = center - first;
+            raw.push_back(1.0 - frac);
+            if (first + 1 < source_size)
+                raw.push_back(frac);
+        }
+        else
+        {
+            // Area: overlap of [i * scale, (i + 1) * scale) with each source pixel
+            const double lo = i * scale;
+            const double hi = std::min((i + 1) * scale, static_cast<double>(source_size));
+            first = static_cast<int32_t>(lo);
+            for (int32_t s = first; s < hi; ++s)
+                raw.push_back((std::min(hi, s + 1.0) - std::max(lo, static_cast<double>(s))) / scale);
+        }
+
+        // Quantize the running sum rather than each weight: the total is exact and the rounding error is spread
+        // over all taps, so even shrink factors past 4096 (where every weight is below one step) keep their mean
+        taps.start.push_back(first);
+        taps.count.push_back(static_cast<int32_t>(raw.size()));
+        taps.offset.push_back(static_cast<uint32_t>(taps.weights.size()));
+        double total = 0.0;
+        for (double w : raw)
+            total += w;
+        double running = 0.0;
+        uint32_t previous = 0;
+        for (double w : raw)
+        {
+            running += w;
+            const uint32_t next = std::min(static_cast<uint32_t>(std::lround(running / total * resample_one)), resample_one);
+            taps.weights.push_back(next - previous);
+            previous = next;
+        }
+        taps.weights.back() += resample_one - previous;
+    }
+    return taps;
+}
+
+// Pack a clamped color into the stored pixel layout
+template <typename Format>
+typename BasicBMPImageCreator<Format>::Pixel BasicBMPImageCreator<Format>::packColor(int r, int g, int b)
+{
+    return Format::pack(static_cast<unsigned char>(std::clamp(r, 0, 255)),
+                        static_cast<unsigned char>(std::clamp(g, 0, 255)),
+                        static_cast<unsigned char>(std::clamp(b, 0, 255)));
+}
+
+// Fill a clipped horizontal span with one pixel value
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillSpan(int32_t x0, int32_t x1, int32_t y, const Pixel &pixel)
+{
+    if (y < 0 || y >= height)
+        return;
+    if (x1 < x0)
+        std::swap(x0, x1);
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, width - 1);
+    if (x0 > x1)
+        return;
+    if (span_gradient)
+    {
+        gradientSpan(x0, x1, y);
+        return;
+    }
+
+    unsigned char *p = pixels.data() + pixelOffset(x0, y);
+    if constexpr (Format::bytes_per_pixel == 1)
+    {
+        std::memset(p, pixel[0], static_cast<size_t>(x1 - x0 + 1));
+    }
+    else
+    {
+        for (int32_t x = x0; x <= x1; ++x, p += Format::bytes_per_pixel)
+        {
+            std::memcpy(p, pixel.data(), Format::bytes_per_pixel);
+        }
+    }
+}
+
+// Turn the stops into a color table and precompute the per-pixel steps
+template <typename Format>
+bool BasicBMPImageCreator<Format>::prepareGradient(const BMPGradient &gradient)
+{
+    if (gradient.stops.empty())
+        return false;
+
+    std::vector<BMPGradientStop> stops = gradient.stops;
+    std::stable_sort(stops.begin(), stops.end(), [](const BMPGradientStop &a, const BMPGradientStop &b)
+                     { return a.position < b.position; });
+
+    GradientSpans &g = gradient_scratch;
+    g.lut.resize(GradientSpans::lut_size);
+    size_t next = 0;
+    for (int32_t i = 0; i < GradientSpans::lut_size; ++i)
+    {
+        const float t = static_cast<float>(i) / (GradientSpans::lut_size - 1);
+        while (next < stops.size() && stops[next].position < t)
+            ++next;
+
+        const BMPGradientStop &hi = stops[std::min(next, stops.size() - 1)];
+        const BMPGradientStop &lo = stops[next == 0 ? 0 : next - 1];
+        float f = hi.position > lo.position ? (t - lo.position) / (hi.position - lo.position) : 0.0f;
+        f = std::clamp(f, 0.0f, 1.0f);
+        g.lut[i] = packColor(static_cast<int>(std::lround(lo.r + (hi.r - lo.r) * f)),
+                             static_cast<int>(std::lround(lo.g + (hi.g - lo.g) * f)),
+                             static_cast<int>(std::lround(lo.b + (hi.b - lo.b) * f)));
+    }
+
+    const double last = GradientSpans::lut_size - 1;
+    g.radial = gradient.type == BMPGradient::Type::Radial;
+    g.x0 = gradient.x0;
+    g.y0 = gradient.y0;
+    g.step_x = 0.0;
+    g.step_y = 0.0;
+    g.scale = 0.0;
+    if (g.radial)
+    {
+        g.scale = gradient.radius > 0 ? last / gradient.radius : 0.0;
+    }
+    else
+    {
+        const double dx = static_cast<double>(gradient.x1) - gradient.x0;
+        const double dy = static_cast<double>(gradient.y1) - gradient.y0;
+        const double length2 = dx * dx + dy * dy;
+        if (length2 > 0.0)
+        {
+            g.step_x = dx * last / length2;
+            g.step_y = dy * last / length2;
+        }
+    }
+    return true;
+}
+
+// Gradient span: the table index advances by a constant (linear) or the squared distance does (radial)
+template <typename Format>
+void BasicBMPImageCreator<Format>::gradientSpan(int32_t x0, int32_t x1, int32_t y)
+{
+    constexpr int32_t last = GradientSpans::lut_size - 1;
+    const GradientSpans &g = *span_gradient;
+    const Pixel *lut = g.lut.data();
+    unsigned char *p = pixels.data() + pixelOffset(x0, y);
+
+    if (!g.radial)
+    {
+        const double start = (static_cast<double>(x0) - g.x0) * g.step_x + (static_cast<double>(y) - g.y0) * g.step_y;
+        int64_t index = std::llround(std::clamp(start, -1e12, 1e12) * 65536.0);
+        const int64_t step = std::llround(g.step_x * 65536.0);
+        for (int32_t x = x0; x <= x1; ++x, p += Format::bytes_per_pixel, index += step)
+        {
+            const int32_t i = static_cast<int32_t>(std::clamp<int64_t>(index >> 16, 0, last));
+            std::memcpy(p, lut[i].data(), Format::bytes_per_pixel);
+        }
+    }
+    else
+    {
+        const int64_t dy = static_cast<int64_t>(y) - g.y0;
+        int64_t dx = static_cast<int64_t>(x0) - g.x0;
+        int64_t distance2 = dx * dx + dy * dy;
+        const float scale = static_cast<float>(g.scale);
+        for (int32_t x = x0; x <= x1; ++x, p += Format::bytes_per_pixel)
+        {
+            const float index = std::sqrt(static_cast<float>(distance2)) * scale;
+            const int32_t i = index < last ? static_cast<int32_t>(index) : last;
+            std::memcpy(p, lut[i].data(), Format::bytes_per_pixel);
+            distance2 += 2 * dx + 1;
+            ++dx;
+        }
+    }
+}
+
+// Fill a clipped vertical run with one pixel value
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillColumn(int32_t x, int32_t y0, int32_t y1, const Pixel &pixel)
+{
+    if (x < 0 || x >= width)
+        return;
+    if (y1 < y0)
+        std::swap(y0, y1);
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, height - 1);
+
+    // Rows are stored bottom-up, so walk from y1 upwards in memory
+    unsigned char *p = y0 <= y1 ? pixels.data() + pixelOffset(x, y1) : nullptr;
+    for (int32_t y = y1; y >= y0; --y, p += row_size)
+    {
+        std::memcpy(p, pixel.data(), Format::bytes_per_pixel);
+    }
+}
+
+// Blend one pixel: dst += (src - dst) * coverage / 256 per channel
+template <typename Format>
+void BasicBMPImageCreator<Format>::blendPixel(int32_t x, int32_t y, const Pixel &pixel, uint32_t coverage)
+{
+    if (x < 0 || x >= width || y < 0 || y >= height || coverage == 0)
+        return;
+
+    unsigned char *p = pixels.data() + pixelOffset(x, y);
+    const int a = static_cast<int>(std::min<uint32_t>(coverage, 256));
+    for (int i = 0; i < Format::bytes_per_pixel; ++i)
+    {
+        p[i] = static_cast<unsigned char>(p[i] + (((pixel[i] - p[i]) * a) >> 8));
+    }
+}
+
+// Blend the four mirror images of (dx,dy) around a center, skipping duplicates on the axes
+template <typename Format>
+void BasicBMPImageCreator<Format>::blendMirrored(int64_t cx, int64_t cy, int64_t dx, int64_t dy, const Pixel &pixel, uint32_t coverage)
+{
+    auto blend = [&](int64_t x, int64_t y)
+    {
+        if (x >= 0 && x < width && y >= 0 && y < height)
+            blendPixel(static_cast<int32_t>(x), static_cast<int32_t>(y), pixel, coverage);
+    };
+    blend(cx + dx, cy + dy);
+    if (dx != 0)
+        blend(cx - dx, cy + dy);
+    if (dy != 0)
+    {
+        blend(cx + dx, cy - dy);
+        if (dx != 0)
+            blend(cx - dx, cy - dy);
+    }
+}
+
+// Collect the pixel centers inside a convex polygon, one span per row. Like scanPolygon, coverage is
+// half-open (top-left rule): a center exactly on the bottom or right edge is outside, so shapes that
+// share an edge never both claim it and a stroke of thickness t covers exactly t rows
+template <typename Format>
+void BasicBMPImageCreator<Format>::addConvexSpans(const PointF *points, int count)
+{
+    double min_y = points[0].y;
+    double max_y = points[0].y;
+    for (int i = 1; i < count; ++i)
+    {
+        min_y = std::min(min_y, points[i].y);
+        max_y = std::max(max_y, points[i].y);
+    }
+
+    const int32_t row0 = static_cast<int32_t>(std::max(std::ceil(min_y - 1e-9), 0.0));
+    const int32_t row1 = static_cast<int32_t>(std::min(std::ceil(max_y - 1e-9) - 1, static_cast<double>(height - 1)));
+    for (int32_t y = row0; y <= row1; ++y)
+    {
+        double lo = HUGE_VAL;
+        double hi = -HUGE_VAL;
+        for (int i = 0; i < count; ++i)
+        {
+            const PointF &a = points[i];
+            const PointF &b = points[(i + 1) % count];
+            if ((a.y < y && b.y < y) || (a.y > y && b.y > y))
+                continue;
+            if (a.y == b.y)
+            {
+                lo = std::min({lo, a.x, b.x});
+                hi = std::max({hi, a.x, b.x});
+            }
+            else
+            {
+                const double x = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+                lo = std::min(lo, x);
+                hi = std::max(hi, x);
+            }
+        }
+        if (lo > hi)
+            continue;
+
+        lo = std::max(std::ceil(lo - 1e-9), 0.0);
+        hi = std::min(std::ceil(hi - 1e-9) - 1, static_cast<double>(width - 1));
+        if (lo <= hi)
+            span_scratch.push_back({y, static_cast<int32_t>(lo), static_cast<int32_t>(hi)});
+    }
+}
+
+// Collect the pixel centers inside a disc, one span per row (half-open like addConvexSpans)
+template <typename Format>
+void BasicBMPImageCreator<Format>::addDiscSpans(double centerX, double centerY, double radius)
+{
+    const int32_t row0 = static_cast<int32_t>(std::max(std::ceil(centerY - radius - 1e-9), 0.0));
+    const int32_t row1 = static_cast<int32_t>(std::min(std::ceil(centerY + radius - 1e-9) - 1, static_cast<double>(height - 1)));
+    for (int32_t y = row0; y <= row1; ++y)
+    {
+        const double dy = y - centerY;
+        const double dx = std::sqrt(std::max(radius * radius - dy * dy, 0.0));
+        const double lo = std::max(std::ceil(centerX - dx - 1e-9), 0.0);
+        const double hi = std::min(std::ceil(centerX + dx - 1e-9) - 1, static_cast<double>(width - 1));
+        if (lo <= hi)
+            span_scratch.push_back({y, static_cast<int32_t>(lo), static_cast<int32_t>(hi)});
+    }
+}
+
+// Sort spans by row, merge overlapping ones and fill what is left
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillCollectedSpans(const Pixel &pixel)
+{
+    std::sort(span_scratch.begin(), span_scratch.end(), [](const Span &a, const Span &b)
+              { return a.y != b.y ? a.y < b.y : a.x0 < b.x0; });
+
+    size_t i = 0;
+    while (i < span_scratch.size())
+    {
+        Span merged = span_scratch[i++];
+        while (i < span_scratch.size() && span_scratch[i].y == merged.y && span_scratch[i].x0 <= merged.x1 + 1)
+        {
+            merged.x1 = std::max(merged.x1, span_scratch[i].x1);
+            ++i;
+        }
+        fillSpan(merged.x0, merged.x1, merged.y, pixel);
+    }
+    span_scratch.clear();
+}
 
 // Constructor
-BMPImageCreator::BMPImageCreator(int32_t width1, int32_t height1)
+template <typename Format>
+BasicBMPImageCreator<Format>::BasicBMPImageCreator(int32_t width1, int32_t height1)
+{
+    reset(width1, height1);
+}
+
+// Check a size against the BMP header limits (all arithmetic in 64 bits, so nothing can wrap)
+template <typename Format>
+bool BasicBMPImageCreator<Format>::validSize(int32_t width1, int32_t height1)
 {
     if (width1 <= 0 || height1 <= 0)
+    {
+        return false;
+    }
+
+    const uint64_t row = (static_cast<uint64_t>(width1) * Format::bytes_per_pixel + 3) / 4 * 4;
+    if (row > max_file_size)
+    {
+        return false;
+    }
+    return row * static_cast<uint64_t>(height1) <= max_file_size - pixel_info_offset;
+}
+
+// Resize and clear the canvas (pixel storage keeps its capacity)
+template <typename Format>
+void BasicBMPImageCreator<Format>::reset(int32_t width1, int32_t height1)
+{
+    if (width1 > 0 && height1 > 0 && !validSize(width1, height1))
+    {
+        throw std::length_error("BMP canvas " + std::to_string(width1) + "x" + std::to_string(height1) +
+                                " does not fit the 32-bit BMP size fields");
+    }
+    if (!validSize(width1, height1))
     {
         width = 10;
         height = 5;
@@ -19,10 +480,13 @@ BMPImageCreator::BMPImageCreator(int32_t width1, int32_t height1)
         height = height1;
     }
 
-    padding_size = (4 - (width * 3) % 4) % 4;
-    row_size = width * 3 + padding_size;
-    pixel_data_size = row_size * height;
-    file_size = file_header_size + bitmap_info_header_size + pixel_data_size;
+    padding_size = (4 - (static_cast<size_t>(width) * Format::bytes_per_pixel) % 4) % 4;
+    row_size = static_cast<size_t>(width) * Format::bytes_per_pixel + padding_size;
+    pixel_data_size = row_size * static_cast<size_t>(height);
+    file_size = pixel_info_offset + pixel_data_size;
+
+    unsigned char *file_header = headers;
+    unsigned char *bitmap_info_header = headers + file_header_size;
 
     file_header[0] = 'B';
     file_header[1] = 'M';
@@ -31,22 +495,9 @@ BMPImageCreator::BMPImageCreator(int32_t width1, int32_t height1)
     file_header[12] = static_cast<unsigned char>(pixel_info_offset >> 16);
     file_header[13] = static_cast<unsigned char>(pixel_info_offset >> 24);
 
-    file_header[2] = static_cast<unsigned char>(file_size);
-    file_header[3] = static_cast<unsigned char>(file_size >> 8);
-    file_header[4] = static_cast<unsigned char>(file_size >> 16);
-    file_header[5] = static_cast<unsigned char>(file_size >> 24);
 
     bitmap_info_header[0] = static_cast<unsigned char>(bitmap_info_header_size);
 
-    bitmap_info_header[4] = static_cast<unsigned char>(width);
-    bitmap_info_header[5] = static_cast<unsigned char>(width >> 8);
-    bitmap_info_header[6] = static_cast<unsigned char>(width >> 16);
-    bitmap_info_header[7] = static_cast<unsigned char>(width >> 24);
-
-    bitmap_info_header[8] = static_cast<unsigned char>(height);
-    bitmap_info_header[9] = static_cast<unsigned char>(height >> 8);
-    bitmap_info_header[10] = static_cast<unsigned char>(height >> 16);
-    bitmap_info_header[11] = static_cast<unsigned char>(height >> 24);
 
     bitmap_info_header[12] = static_cast<unsigned char>(color_planes);
 
@@ -54,10 +505,6 @@ BMPImageCreator::BMPImageCreator(int32_t width1, int32_t height1)
 
     bitmap_info_header[16] = static_cast<unsigned char>(compression);
 
-    bitmap_info_header[20] = static_cast<unsigned char>(pixel_data_size);
-    bitmap_info_header[21] = static_cast<unsigned char>(pixel_data_size >> 8);
-    bitmap_info_header[22] = static_cast<unsigned char>(pixel_data_size >> 16);
-    bitmap_info_header[23] = static_cast<unsigned char>(pixel_data_size >> 24);
 
     bitmap_info_header[24] = static_cast<unsigned char>(resolution);
     bitmap_info_header[25] = static_cast<unsigned char>(resolution >> 8);
@@ -70,47 +517,99 @@ BMPImageCreator::BMPImageCreator(int32_t width1, int32_t height1)
     bitmap_info_header[31] = static_cast<unsigned char>(resolution >> 24);
 
     bitmap_info_header[32] = static_cast<unsigned char>(colors_used);
+    bitmap_info_header[33] = static_cast<unsigned char>(colors_used >> 8);
 
     bitmap_info_header[36] = static_cast<unsigned char>(important_colors);
 
-    pixels = std::vector<std::vector<std::array<unsigned char, 3>>>(
-        height, std::vector<std::array<unsigned char, 3>>(width, {255, 255, 255}));
+    for (int i = 0; i < Format::palette_size; ++i)
+    {
+        Format::paletteEntry(i, headers + file_header_size + bitmap_info_header_size + i * 4);
+    }
+
+    writeGeometry();
 
-    font_chars.resize(char_quantity, std::vector<std::vector<bool>>(char_height, std::vector<bool>(char_width)));
-    cropped_chars.resize(char_quantity, std::vector<std::vector<bool>>(0, std::vector<bool>(0)));
+    pixels.assign(pixel_data_size, 0);
+    setDefaultPixelRGB(255, 255, 255);
 }
 
-// Set default pixel RGB for whole image
-void BMPImageCreator::setDefaultPixelRGB(int r, int g, int b)
+// Write the size-dependent header fields
+template <typename Format>
+void BasicBMPImageCreator<Format>::writeGeometry()
+{
+    writeLittleEndian32(headers + 2, static_cast<uint32_t>(file_size));
+    writeLittleEndian32(headers + file_header_size + 4, static_cast<uint32_t>(width));
+    writeLittleEndian32(headers + file_header_size + 8, static_cast<uint32_t>(height));
+    writeLittleEndian32(headers + file_header_size + 20, static_cast<uint32_t>(pixel_data_size));
+}
+
+// Move constructor (see move assignment)
+template <typename Format>
+BasicBMPImageCreator<Format>::BasicBMPImageCreator(BasicBMPImageCreator &&other) noexcept
 {
-    r = std::clamp(r, 0, 255);
-    g = std::clamp(g, 0, 255);
-    b = std::clamp(b, 0, 255);
+    *this = std::move(other);
+}
 
-    for (size_t y = 0; y < height; ++y)
+// Move assignment: take the pixels and geometry, leaving the source an empty 0x0 canvas that ignores drawing
+template <typename Format>
+BasicBMPImageCreator<Format> &BasicBMPImageCreator<Format>::operator=(BasicBMPImageCreator &&other) noexcept
+{
+    if (this == &other)
     {
-        for (size_t x = 0; x < width; ++x)
-        {
-            pixels[y][x] = {static_cast<unsigned char>(r), static_cast<unsigned char>(g), static_cast<unsigned char>(b)};
-        }
+        return *this;
+    }
+
+    // Scratch buffers are rebuilt on every use, so each canvas keeps its own; swapping the font path
+    // keeps one in the source so drawText still finds a font there
+    font_path.swap(other.font_path);
+    std::memcpy(headers, other.headers, pixel_info_offset);
+    width = other.width;
+    height = other.height;
+    padding_size = other.padding_size;
+    row_size = other.row_size;
+    pixel_data_size = other.pixel_data_size;
+    file_size = other.file_size;
+    pixels = std::move(other.pixels);
+    font = std::move(other.font);
+
+    other.width = 0;
+    other.height = 0;
+    other.padding_size = 0;
+    other.row_size = 0;
+    other.pixel_data_size = 0;
+    other.file_size = pixel_info_offset;
+    other.pixels.clear();
+    other.writeGeometry();
+    return *this;
+}
+
+// Set default pixel RGB for whole image
+template <typename Format>
+void BasicBMPImageCreator<Format>::setDefaultPixelRGB(int r, int g, int b)
+{
+    // Fill the first row, then copy it over the rest (padding stays zero)
+    unsigned char *first_row = pixels.data();
+    fillSpan(0, width - 1, height - 1, packColor(r, g, b));
+    for (int32_t y = 1; y < height; ++y)
+    {
+        std::memcpy(first_row + static_cast<size_t>(y) * row_size, first_row, row_size);
     }
 }
 
 // Set single pixel at (x,y)
-void BMPImageCreator::setPixel(int32_t x, int32_t y, int r, int g, int b)
+template <typename Format>
+void BasicBMPImageCreator<Format>::setPixel(int32_t x, int32_t y, int r, int g, int b)
 {
     if (x < 0 || x >= width || y < 0 || y >= height)
     {
         return;
     }
-    r = std::clamp(r, 0, 255);
-    g = std::clamp(g, 0, 255);
-    b = std::clamp(b, 0, 255);
-    pixels[y][x] = {static_cast<unsigned char>(r), static_cast<unsigned char>(g), static_cast<unsigned char>(b)};
+    const Pixel pixel = packColor(r, g, b);
+    std::memcpy(pixels.data() + pixelOffset(x, y), pixel.data(), Format::bytes_per_pixel);
 }
 
 // Draw rectangle
-void BMPImageCreator::drawRectangle(int32_t x, int32_t y, int32_t x1, int32_t y1, int r, int g, int b, bool fill)
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawRectangle(int32_t x, int32_t y, int32_t x1, int32_t y1, int r, int g, int b, bool fill)
 {
     if (x1 < x)
         std::swap(x, x1);
@@ -119,12 +618,10 @@ void BMPImageCreator::drawRectangle(int32_t x, int32_t y, int32_t x1, int32_t y1
 
     if (fill)
     {
-        for (int32_t i = y; i <= y1; ++i)
+        const Pixel pixel = packColor(r, g, b);
+        for (int32_t i = std::max(y, 0); i <= std::min(y1, height - 1); ++i)
         {
-            for (int32_t j = x; j <= x1; ++j)
-            {
-                setPixel(j, i, r, g, b);
-            }
+            fillSpan(x, x1, i, pixel);
         }
     }
     else
@@ -143,7 +640,8 @@ void BMPImageCreator::drawRectangle(int32_t x, int32_t y, int32_t x1, int32_t y1
 }
 
 // Draw line using Bresenham's algorithm
-void BMPImageCreator::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b)
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b)
 {
     int32_t dx = abs(x1 - x0);
     int32_t dy = -abs(y1 - y0);
@@ -171,7 +669,8 @@ void BMPImageCreator::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, i
 }
 
 // Draw circle (Midpoint Circle Algorithm)
-void BMPImageCreator::drawCircle(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill)
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawCircle(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill)
 {
     if (radius <= 0)
         return;
@@ -184,16 +683,11 @@ void BMPImageCreator::drawCircle(int32_t centerX, int32_t centerY, int32_t radiu
     {
         if (fill)
         {
-            for (int i = centerX - x; i <= centerX + x; ++i)
-            {
-                setPixel(i, centerY + y, r, g, b);
-                setPixel(i, centerY - y, r, g, b);
-            }
-            for (int i = centerX - y; i <= centerX + y; ++i)
-            {
-                setPixel(i, centerY + x, r, g, b);
-                setPixel(i, centerY - x, r, g, b);
-            }
+            const Pixel pixel = packColor(r, g, b);
+            fillSpan(centerX - x, centerX + x, centerY + y, pixel);
+            fillSpan(centerX - x, centerX + x, centerY - y, pixel);
+            fillSpan(centerX - y, centerX + y, centerY + x, pixel);
+            fillSpan(centerX - y, centerX + y, centerY - x, pixel);
         }
         else
         {
@@ -216,104 +710,905 @@ void BMPImageCreator::drawCircle(int32_t centerX, int32_t centerY, int32_t radiu
     }
 }
 
-// Load font from .fnt file
-bool BMPImageCreator::loadFont(const std::string &filename)
+// Draw anti-aliased line (Wu's algorithm, 16.16 fixed point)
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawLineAA(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b)
 {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file)
-        return false;
-
-    for (auto &cols : cropped_chars)
-        cols.clear();
+    const Pixel pixel = packColor(r, g, b);
 
-    for (int c = 0; c < 128; ++c)
+    const bool steep = std::abs(static_cast<int64_t>(y1) - y0) > std::abs(static_cast<int64_t>(x1) - x0);
+    if (steep)
     {
-        for (int y = 0; y < char_height; ++y)
-        {
-            uint8_t byte = file.get();
-            for (int x = 0; x < char_width; ++x)
-            {
-                bool on = (byte >> (7 - x)) & 1;
-                font_chars[c][x][y] = on;
-            }
-        }
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
     }
 
-    std::vector<std::vector<int>> empty_columns(128);
-    for (int i = 0; i < font_chars.size(); ++i)
+    const int64_t dx = static_cast<int64_t>(x1) - x0;
+    const int64_t dy = static_cast<int64_t>(y1) - y0;
+    const int64_t gradient = dx == 0 ? 0 : (dy * 65536) / dx;
+
+    // Only walk the part of the major axis that can land on the canvas
+    const int32_t major_limit = (steep ? height : width) - 1;
+    const int32_t start = std::max<int32_t>(x0, 0);
+    const int32_t end = std::min<int32_t>(x1, major_limit);
+    int64_t intery = static_cast<int64_t>(y0) * 65536 + gradient * (static_cast<int64_t>(start) - x0);
+
+    for (int32_t x = start; x <= end; ++x, intery += gradient)
     {
-        if (i != 32)
+        const int32_t y = static_cast<int32_t>(intery >> 16);
+        const uint32_t frac = static_cast<uint32_t>(intery & 0xFFFF) >> 8;
+        if (steep)
         {
-            for (int cx = 0; cx < char_width; ++cx)
-            {
-                bool empty = true;
-                for (int cy = 0; cy < char_height; ++cy)
-                {
-                    if (font_chars[i][cx][cy])
-                    {
-                        empty = false;
-                        break;
-                    }
-                }
-                if (empty)
-                {
-                    empty_columns[i].push_back(cx);
-                }
-            }
+            blendPixel(y, x, pixel, 256 - frac);
+            blendPixel(y + 1, x, pixel, frac);
         }
         else
         {
-            for (int j = 0; j < 5; ++j)
-            {
-                empty_columns[i].push_back(j);
-            }
+            blendPixel(x, y, pixel, 256 - frac);
+            blendPixel(x, y + 1, pixel, frac);
         }
     }
+}
+
+// Draw anti-aliased circle (Wu's circle: exact edge position per column in 8.8 fixed point)
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawCircleAA(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill)
+{
+    if (radius <= 0)
+        return;
+
+    const Pixel pixel = packColor(r, g, b);
+    const int64_t r2 = static_cast<int64_t>(radius) * radius;
 
-    std::vector<bool> column_buffer;
-    for (int i = 0; i < font_chars.size(); ++i)
+    // Only offsets that land on a visible column or row are walked, so a huge or mostly off-canvas
+    // circle costs at most about width + height steps
+    int64_t column_first, column_last, row_first, row_last;
+    visibleOffsets(centerX, width, column_first, column_last);
+    visibleOffsets(centerY, height, row_first, row_last);
+
+    // Solid interior: every pixel whose center lies inside the circle (spans clamped before narrowing)
+    if (fill)
     {
-        for (int cx = 0; cx < char_width; ++cx)
+        for (int64_t y = row_first; y <= std::min<int64_t>(row_last, radius); ++y)
         {
-            if (std::find(empty_columns[i].begin(), empty_columns[i].end(), cx) == empty_columns[i].end())
-            {
-                for (int cy = 0; cy < 8; ++cy)
-                {
-                    column_buffer.push_back(font_chars[i][cx][cy]);
-                }
-                cropped_chars[i].push_back(column_buffer);
-                column_buffer.clear();
-            }
+            const int64_t x_edge = static_cast<int64_t>(isqrt64(static_cast<uint64_t>(r2 - y * y)));
+            const int32_t x0 = static_cast<int32_t>(std::max<int64_t>(centerX - x_edge, -1));
+            const int32_t x1 = static_cast<int32_t>(std::min<int64_t>(centerX + x_edge, width));
+            fillSpan(x0, x1, static_cast<int32_t>(centerY + y), pixel);
+            if (y != 0)
+                fillSpan(x0, x1, static_cast<int32_t>(centerY - y), pixel);
         }
     }
 
-    return true;
-}
+    // Edge: one octant, mirrored; the pixel outside the edge gets the fractional coverage.
+    // Offset x is a column for the (x, y) images and a row for the (y, x) ones, so any x outside both
+    // visible ranges draws nothing; walking the two ranges in ascending order keeps the blend order intact
+    auto edgeStep = [&](int64_t x)
+    {
+        const uint64_t y_fixed = isqrt64Fixed8(static_cast<uint64_t>(r2 - x * x));
+        const int64_t y = static_cast<int64_t>(y_fixed >> 8);
+        const uint32_t frac = static_cast<uint32_t>(y_fixed & 0xFF);
+        if (x > y)
+            return false;
 
-// Draw text with loaded font
-void BMPImageCreator::drawText(int startX, int startY, const std::string &text, int r, int g, int b, int scale, bool wrap)
-{
-    if (!font_loaded && !loadFont(font_path))
+        if (!fill)
+        {
+            blendMirrored(centerX, centerY, x, y, pixel, 256 - frac);
+            if (x != y)
+                blendMirrored(centerX, centerY, y, x, pixel, 256 - frac);
+        }
+        blendMirrored(centerX, centerY, x, y + 1, pixel, frac);
+        blendMirrored(centerX, centerY, y + 1, x, pixel, frac);
+        return true;
+    };
+
+    std::pair<int64_t, int64_t> ranges[2] = {{column_first, column_last}, {row_first, row_last}};
+    if (ranges[1].first < ranges[0].first)
+        std::swap(ranges[0], ranges[1]);
+    int64_t x = ranges[0].first;
+    for (const auto &range : ranges)
     {
-        std::cerr << "Fatal error: font file not found\n";
-        std::exit(1);
-        return;
+        for (x = std::max(x, range.first); x <= std::min<int64_t>(range.second, radius); ++x)
+        {
+            if (!edgeStep(x))
+                return;
+        }
     }
-    font_loaded = true;
+}
 
-    int current_x = startX;
-    int current_y = startY;
-    bool wrapped = false;
+// Scanline polygon fill with an edge table / active edge list.
+// Pixel (x,y) is inside when its center is; edges are half-open (top row in, bottom row out)
+// and spans run from the left crossing up to but not including the right one.
+template <typename Format>
+void BasicBMPImageCreator<Format>::scanPolygon(const BMPPoint *points, size_t count, const Pixel &pixel, BMPFillRule rule)
+{
+    if (count < 3)
+        return;
 
-    std::vector<std::string> words;
-    std::string cur;
-    for (char ch : text)
+    // Build the edge table, skipping horizontal edges and anything entirely above or below the canvas
+    edge_scratch.clear();
+    for (size_t i = 0; i < count; ++i)
     {
-        if (ch == '\n')
+        BMPPoint a = points[i];
+        BMPPoint b = points[(i + 1) % count];
+        if (a.y == b.y)
+            continue;
+
+        int32_t dir = 1;
+        if (a.y > b.y)
         {
-            if (!cur.empty())
-            {
-                words.push_back(cur);
+            std::swap(a, b);
+            dir = -1;
+        }
+        if (b.y <= 0 || a.y >= height)
+            continue;
+
+        Edge edge;
+        edge.y_start = std::max(a.y, 0);
+        edge.y_end = std::min(b.y, height);
+        edge.dir = dir;
+        edge.dy = static_cast<int64_t>(b.y) - a.y;
+
+        const int64_t dx = static_cast<int64_t>(b.x) - a.x;
+        const int64_t num = (static_cast<int64_t>(edge.y_start) - a.y) * dx;
+        int64_t q = num / edge.dy;
+        if (num % edge.dy < 0)
+            --q;
+        edge.x = a.x + q;
+        edge.rem = num - q * edge.dy;
+
+        edge.x_step = dx / edge.dy;
+        if (dx % edge.dy < 0)
+            --edge.x_step;
+        edge.rem_step = dx - edge.x_step * edge.dy;
+
+        edge_scratch.push_back(edge);
+    }
+    if (edge_scratch.empty())
+        return;
+
+    std::sort(edge_scratch.begin(), edge_scratch.end(), [](const Edge &a, const Edge &b)
+              { return a.y_start < b.y_start; });
+
+    active_scratch.clear();
+    size_t next_edge = 0;
+    for (int32_t y = edge_scratch[0].y_start; y < height; ++y)
+    {
+        // Retire finished edges, activate the ones starting here
+        active_scratch.erase(std::remove_if(active_scratch.begin(), active_scratch.end(), [y](const Edge &e)
+                                            { return e.y_end <= y; }),
+                             active_scratch.end());
+        while (next_edge < edge_scratch.size() && edge_scratch[next_edge].y_start == y)
+        {
+            active_scratch.push_back(edge_scratch[next_edge++]);
+        }
+        if (active_scratch.empty())
+        {
+            if (next_edge == edge_scratch.size())
+                break;
+            y = edge_scratch[next_edge].y_start - 1;
+            continue;
+        }
+
+        // Keep the list ordered by crossing (insertion sort, it is nearly sorted row to row)
+        for (size_t i = 1; i < active_scratch.size(); ++i)
+        {
+            Edge e = active_scratch[i];
+            size_t j = i;
+            while (j > 0 && active_scratch[j - 1].crossing() > e.crossing())
+            {
+                active_scratch[j] = active_scratch[j - 1];
+                --j;
+            }
+            active_scratch[j] = e;
+        }
+
+        // Walk the crossings and fill the inside intervals
+        int32_t winding = 0;
+        for (size_t i = 0; i + 1 < active_scratch.size(); ++i)
+        {
+            winding += active_scratch[i].dir;
+            const bool inside = rule == BMPFillRule::EvenOdd ? ((i + 1) % 2 == 1) : winding != 0;
+            if (!inside)
+                continue;
+
+            const int64_t x0 = std::max<int64_t>(active_scratch[i].crossing(), 0);
+            const int64_t x1 = std::min<int64_t>(active_scratch[i + 1].crossing() - 1, width - 1);
+            if (x0 <= x1)
+                fillSpan(static_cast<int32_t>(x0), static_cast<int32_t>(x1), y, pixel);
+        }
+
+        // Step every active edge to the next row
+        for (Edge &e : active_scratch)
+        {
+            e.x += e.x_step;
+            e.rem += e.rem_step;
+            if (e.rem >= e.dy)
+            {
+                e.rem -= e.dy;
+                ++e.x;
+            }
+        }
+    }
+}
+
+// Flood fill with a scanline span stack: memory grows with the number of pending spans, not pixels
+template <typename Format>
+void BasicBMPImageCreator<Format>::floodFill(int32_t x, int32_t y, int r, int g, int b)
+{
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return;
+
+    const Pixel pixel = packColor(r, g, b);
+    Pixel target;
+    std::memcpy(target.data(), pixels.data() + pixelOffset(x, y), Format::bytes_per_pixel);
+    if (target == pixel)
+        return;
+
+    auto inside = [&](int32_t px, int32_t py)
+    {
+        return px >= 0 && px < width && py >= 0 && py < height &&
+               std::memcmp(pixels.data() + pixelOffset(px, py), target.data(), Format::bytes_per_pixel) == 0;
+    };
+
+    // Pending work: columns x1..x2 of row y, reached while moving in direction dy
+    struct Segment
+    {
+        int32_t x1;
+        int32_t x2;
+        int32_t y;
+        int32_t dy;
+    };
+    std::vector<Segment> stack = {{x, x, y, 1}, {x, x, y - 1, -1}};
+
+    while (!stack.empty())
+    {
+        Segment s = stack.back();
+        stack.pop_back();
+        if (s.y < 0 || s.y >= height)
+            continue;
+
+        int32_t x1 = s.x1;
+        int32_t left = x1;
+
+        // Extend to the left of the segment, leaking back into the row we came from if needed
+        if (inside(left, s.y))
+        {
+            while (inside(left - 1, s.y))
+                --left;
+            if (left < x1)
+            {
+                fillSpan(left, x1 - 1, s.y, pixel);
+                stack.push_back({left, x1 - 1, s.y - s.dy, -s.dy});
+            }
+        }
+
+        while (x1 <= s.x2)
+        {
+            // Run of matching pixels starting at x1
+            int32_t run_end = x1;
+            while (inside(run_end, s.y))
+                ++run_end;
+            if (run_end > x1)
+                fillSpan(x1, run_end - 1, s.y, pixel);
+            x1 = run_end;
+
+            if (x1 > left)
+                stack.push_back({left, x1 - 1, s.y + s.dy, s.dy});
+            if (x1 - 1 > s.x2)
+                stack.push_back({s.x2 + 1, x1 - 1, s.y - s.dy, -s.dy});
+
+            // Skip the gap to the next matching pixel inside the segment
+            ++x1;
+            while (x1 < s.x2 && !inside(x1, s.y))
+                ++x1;
+            left = x1;
+        }
+    }
+}
+
+// Fill rectangle with a gradient
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillRectangleGradient(int32_t x, int32_t y, int32_t x1, int32_t y1, const BMPGradient &gradient)
+{
+    if (!prepareGradient(gradient))
+        return;
+    span_gradient = &gradient_scratch;
+    drawRectangle(x, y, x1, y1, 0, 0, 0, true);
+    span_gradient = nullptr;
+}
+
+// Fill circle with a gradient
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillCircleGradient(int32_t centerX, int32_t centerY, int32_t radius, const BMPGradient &gradient)
+{
+    if (!prepareGradient(gradient))
+        return;
+    span_gradient = &gradient_scratch;
+    drawCircle(centerX, centerY, radius, 0, 0, 0, true);
+    span_gradient = nullptr;
+}
+
+// Fill polygon with a gradient
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillPolygonGradient(const std::vector<BMPPoint> &points, const BMPGradient &gradient, BMPFillRule rule)
+{
+    if (!prepareGradient(gradient))
+        return;
+    span_gradient = &gradient_scratch;
+    scanPolygon(points.data(), points.size(), Pixel{}, rule);
+    span_gradient = nullptr;
+}
+
+// Draw time series, decimated to one vertical span per pixel column
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawSeries(const float *samples, size_t count, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                                              float min_value, float max_value, int r, int g, int b)
+{
+    if (samples == nullptr || count == 0 || x1 < x0)
+        return;
+
+    const Pixel pixel = packColor(r, g, b);
+    const size_t columns = static_cast<size_t>(static_cast<int64_t>(x1) - x0 + 1);
+    const double range = max_value != min_value ? static_cast<double>(max_value) - min_value : 1.0;
+    const double scale = (static_cast<double>(y1) - y0) / range;
+    const double base = max_value != min_value ? min_value : min_value - 0.5;
+    auto mapY = [&](float value)
+    {
+        const double y = y1 - (value - base) * scale;
+        return static_cast<int32_t>(std::lround(std::clamp(y, -1.0, static_cast<double>(height))));
+    };
+
+    // Fewer samples than columns: plain line segments are already width-bound
+    if (count < columns)
+    {
+        int32_t prev_x = x0;
+        int32_t prev_y = mapY(samples[0]);
+        setPixel(prev_x, prev_y, r, g, b);
+        for (size_t i = 1; i < count; ++i)
+        {
+            const int32_t x = x0 + static_cast<int32_t>(i * (columns - 1) / (count - 1));
+            const int32_t y = mapY(samples[i]);
+            drawLine(prev_x, prev_y, x, y, r, g, b);
+            prev_x = x;
+            prev_y = y;
+        }
+        return;
+    }
+
+    // Column c holds samples [ceil(c * count / columns), ceil((c + 1) * count / columns))
+    auto columnStart = [&](size_t c)
+    { return static_cast<size_t>((static_cast<unsigned long long>(c) * count + columns - 1) / columns); };
+
+    int32_t prev_last = 0;
+    size_t start = 0;
+    for (size_t c = 0; c < columns; ++c)
+    {
+        const size_t end = columnStart(c + 1);
+        const int32_t x = x0 + static_cast<int32_t>(c);
+
+        // Plain min/max reduction over a contiguous range (vectorizes)
+        float lo = samples[start];
+        float hi = samples[start];
+        for (size_t i = start + 1; i < end; ++i)
+        {
+            const float v = samples[i];
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+
+        // Larger values are higher up, so max maps to the smaller y
+        int32_t top = mapY(hi);
+        int32_t bottom = mapY(lo);
+        const int32_t first = mapY(samples[start]);
+        const int32_t last = mapY(samples[end - 1]);
+
+        // Meet the neighbours halfway so the trace stays connected, like a line per segment would
+        if (c > 0)
+        {
+            const int32_t link = (prev_last + first) / 2;
+            top = std::min(top, link);
+            bottom = std::max(bottom, link);
+        }
+        if (c + 1 < columns)
+        {
+            const int32_t link = (last + mapY(samples[end])) / 2;
+            top = std::min(top, link);
+            bottom = std::max(bottom, link);
+        }
+
+        if (x >= 0 && x < width)
+            fillColumn(x, top, bottom, pixel);
+
+        prev_last = last;
+        start = end;
+    }
+}
+
+// Fill polygon
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillPolygon(const std::vector<BMPPoint> &points, int r, int g, int b, BMPFillRule rule)
+{
+    scanPolygon(points.data(), points.size(), packColor(r, g, b), rule);
+}
+
+// Fill many polygons, each in its own color, sharing the edge buffers
+template <typename Format>
+void BasicBMPImageCreator<Format>::fillPolygons(const std::vector<BMPPolygon> &polygons, BMPFillRule rule)
+{
+    for (const BMPPolygon &polygon : polygons)
+    {
+        scanPolygon(polygon.points.data(), polygon.points.size(), packColor(polygon.r, polygon.g, polygon.b), rule);
+    }
+}
+
+// Stroke a path: segment quads, joins and caps are turned into spans and merged before filling
+template <typename Format>
+void BasicBMPImageCreator<Format>::strokePath(const BMPPoint *points, size_t count, int thickness, const Pixel &pixel,
+                                              BMPLineJoin join, BMPLineCap cap)
+{
+    constexpr double miter_limit = 4.0;
+
+    if (count == 0 || thickness <= 0)
+        return;
+
+    // Drop repeated points so every segment has a direction
+    path_scratch.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i == 0 || points[i].x != points[i - 1].x || points[i].y != points[i - 1].y)
+            path_scratch.push_back({static_cast<double>(points[i].x), static_cast<double>(points[i].y)});
+    }
+    const std::vector<PointF> &path = path_scratch;
+    const size_t n = path.size();
+    const double hw = thickness / 2.0;
+
+    if (n == 1)
+    {
+        const PointF &p = path[0];
+        if (cap == BMPLineCap::Round)
+        {
+            addDiscSpans(p.x, p.y, hw);
+        }
+        else if (cap == BMPLineCap::Square)
+        {
+            const PointF square[4] = {{p.x - hw, p.y - hw}, {p.x + hw, p.y - hw}, {p.x + hw, p.y + hw}, {p.x - hw, p.y + hw}};
+            addConvexSpans(square, 4);
+        }
+        fillCollectedSpans(pixel);
+        return;
+    }
+
+    PointF prev_normal{0.0, 0.0};
+    PointF prev_dir{0.0, 0.0};
+    for (size_t i = 0; i + 1 < n; ++i)
+    {
+        PointF a = path[i];
+        PointF b = path[i + 1];
+        const double length = std::hypot(b.x - a.x, b.y - a.y);
+        const PointF dir{(b.x - a.x) / length, (b.y - a.y) / length};
+        const PointF normal{-dir.y, dir.x};
+
+        // Caps
+        if (i == 0)
+        {
+            if (cap == BMPLineCap::Square)
+                a = {a.x - dir.x * hw, a.y - dir.y * hw};
+            else if (cap == BMPLineCap::Round)
+                addDiscSpans(a.x, a.y, hw);
+        }
+        if (i + 2 == n)
+        {
+            if (cap == BMPLineCap::Square)
+                b = {b.x + dir.x * hw, b.y + dir.y * hw};
+            else if (cap == BMPLineCap::Round)
+                addDiscSpans(b.x, b.y, hw);
+        }
+
+        const PointF quad[4] = {{a.x + normal.x * hw, a.y + normal.y * hw},
+                                {b.x + normal.x * hw, b.y + normal.y * hw},
+                                {b.x - normal.x * hw, b.y - normal.y * hw},
+                                {a.x - normal.x * hw, a.y - normal.y * hw}};
+        addConvexSpans(quad, 4);
+
+        // Join with the previous segment on the outer side of the turn
+        if (i > 0)
+        {
+            const PointF &v = path[i];
+            const double cross = prev_dir.x * dir.y - prev_dir.y * dir.x;
+            const double dot = prev_dir.x * dir.x + prev_dir.y * dir.y;
+            if (join == BMPLineJoin::Round)
+            {
+                addDiscSpans(v.x, v.y, hw);
+            }
+            else if (std::abs(cross) > 1e-12 || dot < 0)
+            {
+                const double side = (prev_normal.x * dir.x + prev_normal.y * dir.y) > 0 ? -1.0 : 1.0;
+                const PointF outer0{v.x + side * prev_normal.x * hw, v.y + side * prev_normal.y * hw};
+                const PointF outer1{v.x + side * normal.x * hw, v.y + side * normal.y * hw};
+
+                const double sum_x = prev_normal.x + normal.x;
+                const double sum_y = prev_normal.y + normal.y;
+                const double sum_length = std::hypot(sum_x, sum_y);
+                const double miter_length = sum_length > 1e-12 ? hw * 2.0 / sum_length : HUGE_VAL;
+
+                if (join == BMPLineJoin::Miter && miter_length <= hw * miter_limit)
+                {
+                    const PointF tip{v.x + side * sum_x / sum_length * miter_length, v.y + side * sum_y / sum_length * miter_length};
+                    const PointF miter[4] = {v, outer0, tip, outer1};
+                    addConvexSpans(miter, 4);
+                }
+                else
+                {
+                    const PointF bevel[3] = {v, outer0, outer1};
+                    addConvexSpans(bevel, 3);
+                }
+            }
+        }
+
+        prev_normal = normal;
+        prev_dir = dir;
+    }
+
+    fillCollectedSpans(pixel);
+}
+
+// Draw thick line
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawThickLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int thickness, int r, int g, int b,
+                                                 BMPLineCap cap)
+{
+    const BMPPoint points[2] = {{x0, y0}, {x1, y1}};
+    strokePath(points, 2, thickness, packColor(r, g, b), BMPLineJoin::Miter, cap);
+}
+
+// Draw thick polyline through the given points
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawPolyline(const std::vector<BMPPoint> &points, int thickness, int r, int g, int b,
+                                                BMPLineJoin join, BMPLineCap cap)
+{
+    strokePath(points.data(), points.size(), thickness, packColor(r, g, b), join, cap);
+}
+
+// Resample into a new canvas: a vertical pass blends source rows into a row accumulator,
+// then a horizontal pass blends accumulator pixels into the destination row
+template <typename Format>
+BasicBMPImageCreator<Format> BasicBMPImageCreator<Format>::resized(int32_t new_width, int32_t new_height, BMPResampleFilter filter,
+                                                                   unsigned threads) const
+{
+    constexpr int bpp = Format::bytes_per_pixel;
+
+    // Taps are built for the canvas that was actually created (sizes too large for a BMP throw here)
+    BasicBMPImageCreator result(std::max(new_width, 1), std::max(new_height, 1));
+    new_width = result.getWidth();
+    new_height = result.getHeight();
+    if (width == 0 || height == 0)
+    {
+        return result;
+    }
+
+    const ResampleTaps columns = buildResampleTaps(width, new_width, filter);
+    const ResampleTaps rows = buildResampleTaps(height, new_height, filter);
+    const size_t row_bytes = static_cast<size_t>(width) * bpp;
+
+    auto band = [&](int32_t y_begin, int32_t y_end)
+    {
+        std::vector<uint32_t> accumulator(row_bytes);
+        for (int32_t y = y_begin; y < y_end; ++y)
+        {
+            // Vertical pass over whole rows
+            std::fill(accumulator.begin(), accumulator.end(), 0);
+            for (int32_t t = 0; t < rows.count[y]; ++t)
+            {
+                const uint32_t w = rows.weights[rows.offset[y] + t];
+                const unsigned char *src = rowData(rows.start[y] + t);
+                for (size_t k = 0; k < row_bytes; ++k)
+                    accumulator[k] += w * src[k];
+            }
+
+            // Horizontal pass
+            unsigned char *dst = result.rowData(y);
+            for (int32_t x = 0; x < new_width; ++x)
+            {
+                uint32_t sum[bpp] = {0};
+                const uint32_t *acc = accumulator.data() + static_cast<size_t>(columns.start[x]) * bpp;
+                for (int32_t t = 0; t < columns.count[x]; ++t, acc += bpp)
+                {
+                    const uint32_t w = columns.weights[columns.offset[x] + t];
+                    for (int c = 0; c < bpp; ++c)
+                        sum[c] += w * acc[c];
+                }
+                for (int c = 0; c < bpp; ++c)
+                    dst[static_cast<size_t>(x) * bpp + c] = static_cast<unsigned char>((sum[c] + (1u << 23)) >> 24);
+            }
+        }
+    };
+
+    parallelBands(new_height, threads, [&](int64_t begin, int64_t end)
+                  { band(static_cast<int32_t>(begin), static_cast<int32_t>(end)); });
+    return result;
+}
+
+// Box-filter down by an integer factor (e.g. resolve a 2x or 4x supersampled render)
+template <typename Format>
+BasicBMPImageCreator<Format> BasicBMPImageCreator<Format>::resolve(int factor, unsigned threads) const
+{
+    factor = std::max(factor, 1);
+    return resized(width / factor, height / factor, BMPResampleFilter::Area, threads);
+}
+
+// Horizontal box pass: each row keeps one running sum per channel
+template <typename Format>
+void BasicBMPImageCreator<Format>::boxBlurRows(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned threads)
+{
+    constexpr int bpp = Format::bytes_per_pixel;
+    const int32_t span = x1 - x0 + 1;
+    // Rounded 2^32 / (2 * radius + 1): the error stays under a quarter LSB for every radius up to max_blur_radius
+    const uint64_t inverse = ((uint64_t(1) << 32) + radius) / static_cast<uint64_t>(2 * radius + 1);
+
+    parallelBands(static_cast<int64_t>(y1) - y0 + 1, threads, [&](int64_t begin, int64_t end)
+                  {
+        std::vector<unsigned char> source(static_cast<size_t>(span) * bpp);
+        for (int64_t row = begin; row < end; ++row)
+        {
+            unsigned char *dst = rowData(y0 + static_cast<int32_t>(row)) + static_cast<size_t>(x0) * bpp;
+            std::memcpy(source.data(), dst, source.size());
+            auto at = [&](int32_t i, int c)
+            { return source[static_cast<size_t>(std::clamp(i, 0, span - 1)) * bpp + c]; };
+
+            // Window around x = 0, with the clamped edge samples counted in bulk (O(span) for any radius)
+            const int32_t inside = std::min(radius, span - 1);
+            uint32_t sum[bpp];
+            for (int c = 0; c < bpp; ++c)
+            {
+                sum[c] = static_cast<uint32_t>(radius) * at(0, c) + static_cast<uint32_t>(radius - inside) * at(span - 1, c);
+                for (int32_t i = 0; i <= inside; ++i)
+                    sum[c] += at(i, c);
+            }
+            for (int32_t x = 0; x < span; ++x)
+            {
+                for (int c = 0; c < bpp; ++c)
+                {
+                    dst[static_cast<size_t>(x) * bpp + c] = static_cast<unsigned char>((sum[c] * inverse + (uint64_t(1) << 31)) >> 32);
+                    sum[c] += at(x + radius + 1, c) - at(x - radius, c);
+                }
+            }
+        } });
+}
+
+// Vertical box pass: one running sum per byte of the row, updated a whole row at a time (vectorizes)
+template <typename Format>
+void BasicBMPImageCreator<Format>::boxBlurColumns(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned threads)
+{
+    constexpr int bpp = Format::bytes_per_pixel;
+    const int32_t rows = y1 - y0 + 1;
+    // Rounded 2^32 / (2 * radius + 1): the error stays under a quarter LSB for every radius up to max_blur_radius
+    const uint64_t inverse = ((uint64_t(1) << 32) + radius) / static_cast<uint64_t>(2 * radius + 1);
+
+    // Threads take vertical strips so each keeps its own copy of the source columns
+    parallelBands(static_cast<int64_t>(x1) - x0 + 1, threads, [&](int64_t begin, int64_t end)
+                  {
+        const size_t strip = static_cast<size_t>(end - begin) * bpp;
+        const size_t offset = static_cast<size_t>(x0 + begin) * bpp;
+        std::vector<unsigned char> source(strip * rows);
+        for (int32_t y = 0; y < rows; ++y)
+            std::memcpy(source.data() + y * strip, rowData(y0 + y) + offset, strip);
+        auto row = [&](int32_t y)
+        { return source.data() + static_cast<size_t>(std::clamp(y, 0, rows - 1)) * strip; };
+
+        // Window around y = 0, with the clamped edge rows counted in bulk
+        const int32_t inside = std::min(radius, rows - 1);
+        std::vector<uint32_t> sum(strip, 0);
+        for (size_t k = 0; k < strip; ++k)
+            sum[k] = static_cast<uint32_t>(radius) * row(0)[k] + static_cast<uint32_t>(radius - inside) * row(rows - 1)[k];
+        for (int32_t i = 0; i <= inside; ++i)
+        {
+            const unsigned char *src = row(i);
+            for (size_t k = 0; k < strip; ++k)
+                sum[k] += src[k];
+        }
+        for (int32_t y = 0; y < rows; ++y)
+        {
+            unsigned char *dst = rowData(y0 + y) + offset;
+            const unsigned char *add = row(y + radius + 1);
+            const unsigned char *sub = row(y - radius);
+            for (size_t k = 0; k < strip; ++k)
+            {
+                dst[k] = static_cast<unsigned char>((sum[k] * inverse + (uint64_t(1) << 31)) >> 32);
+                sum[k] += add[k] - sub[k];
+            }
+        } });
+}
+
+// Box blur of the whole canvas
+template <typename Format>
+void BasicBMPImageCreator<Format>::boxBlur(int radius, unsigned threads)
+{
+    boxBlur(0, 0, width - 1, height - 1, radius, threads);
+}
+
+// Box blur of a rectangle (edges are extended, pixels outside the rectangle are not read)
+template <typename Format>
+void BasicBMPImageCreator<Format>::boxBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned threads)
+{
+    if (x1 < x0)
+        std::swap(x0, x1);
+    if (y1 < y0)
+        std::swap(y0, y1);
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width - 1);
+    y1 = std::min(y1, height - 1);
+    if (radius <= 0 || x0 > x1 || y0 > y1)
+        return;
+    radius = std::min(radius, max_blur_radius);
+
+    boxBlurRows(x0, y0, x1, y1, radius, threads);
+    boxBlurColumns(x0, y0, x1, y1, radius, threads);
+}
+
+// Gaussian blur of the whole canvas
+template <typename Format>
+void BasicBMPImageCreator<Format>::gaussianBlur(float sigma, unsigned threads)
+{
+    gaussianBlur(0, 0, width - 1, height - 1, sigma, threads);
+}
+
+// Gaussian blur approximated by three box blurs with matching variance
+template <typename Format>
+void BasicBMPImageCreator<Format>::gaussianBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, float sigma, unsigned threads)
+{
+    if (!(sigma > 0.0f))
+        return;
+
+    // The box radii come out close to sigma, so the same bound as boxBlur applies; sizes are worked out in double
+    constexpr int passes = 3;
+    const double clamped = std::min(static_cast<double>(sigma), static_cast<double>(max_blur_radius));
+    const double variance = 12.0 * clamped * clamped;
+    int lower = static_cast<int>(std::sqrt(variance / passes + 1.0));
+    if (lower % 2 == 0)
+        --lower;
+    const double lower_size = lower;
+    const int lower_count = static_cast<int>(std::lround((variance - passes * lower_size * lower_size - 4.0 * passes * lower_size - 3.0 * passes) / (-4.0 * lower_size - 4.0)));
+
+    for (int i = 0; i < passes; ++i)
+    {
+        const int size = i < lower_count ? lower : lower + 2;
+        boxBlur(x0, y0, x1, y1, (size - 1) / 2, threads);
+    }
+}
+
+// Drop shadow: blur a rectangle mask and blend the shadow color through it
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawShadow(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int blur_radius, int r, int g, int b, int opacity)
+{
+    if (x1 < x0)
+        std::swap(x0, x1);
+    if (y1 < y0)
+        std::swap(y0, y1);
+    blur_radius = std::clamp(blur_radius, 0, max_blur_radius);
+    opacity = std::clamp(opacity, 0, 255);
+
+    // Three box passes spread the edge by up to 3 * radius; only the visible part of that gets drawn
+    const int64_t margin = 3 * static_cast<int64_t>(blur_radius);
+    const int64_t left = std::max<int64_t>(x0 - margin, 0);
+    const int64_t top = std::max<int64_t>(y0 - margin, 0);
+    const int64_t right = std::min<int64_t>(x1 + margin, width - 1);
+    const int64_t bottom = std::min<int64_t>(y1 + margin, height - 1);
+    if (left > right || top > bottom)
+        return;
+
+    // The mask covers the visible area plus the margin, so every visible pixel sees the same
+    // neighbourhood as with an unclipped mask (edge clamping only affects the margin itself)
+    const int64_t mask_x = left - margin;
+    const int64_t mask_y = top - margin;
+    const int64_t mask_width = right - left + 1 + 2 * margin;
+    const int64_t mask_height = bottom - top + 1 + 2 * margin;
+    if (mask_width > INT32_MAX || mask_height > INT32_MAX ||
+        !BasicBMPImageCreator<Gray8>::validSize(static_cast<int32_t>(mask_width), static_cast<int32_t>(mask_height)))
+        return;
+
+    auto toMask = [](int64_t value, int64_t size)
+    { return static_cast<int32_t>(std::clamp<int64_t>(value, -1, size)); };
+
+    BasicBMPImageCreator<Gray8> mask(static_cast<int32_t>(mask_width), static_cast<int32_t>(mask_height));
+    mask.setDefaultPixelRGB(0, 0, 0);
+    mask.drawRectangle(toMask(x0 - mask_x, mask_width), toMask(y0 - mask_y, mask_height),
+                       toMask(x1 - mask_x, mask_width), toMask(y1 - mask_y, mask_height), 255, 255, 255, true);
+    for (int i = 0; i < 3; ++i)
+        mask.boxBlur(blur_radius);
+
+    const Pixel pixel = packColor(r, g, b);
+    for (int32_t y = static_cast<int32_t>(top); y <= bottom; ++y)
+    {
+        const unsigned char *coverage = mask.rowData(static_cast<int32_t>(y - mask_y));
+        for (int32_t x = static_cast<int32_t>(left); x <= right; ++x)
+        {
+            const uint32_t c = coverage[x - mask_x];
+            blendPixel(x, y, pixel, (c * static_cast<uint32_t>(opacity) * 256 + 255 * 255 / 2) / (255 * 255));
+        }
+    }
+}
+
+// Copy a row as packed RGB
+template <typename Format>
+void BasicBMPImageCreator<Format>::readRowRGB(int32_t y, unsigned char *out) const
+{
+    const unsigned char *row = rowData(y);
+    for (int32_t x = 0; x < width; ++x, row += Format::bytes_per_pixel, out += 3)
+    {
+        const std::array<unsigned char, 3> color = Format::unpack(row);
+        out[0] = color[0];
+        out[1] = color[1];
+        out[2] = color[2];
+    }
+}
+
+// Copy a row as packed BGR (a plain copy for 24-bit canvases)
+template <typename Format>
+void BasicBMPImageCreator<Format>::readRowBGR(int32_t y, unsigned char *out) const
+{
+    const unsigned char *row = rowData(y);
+    if constexpr (std::is_same_v<Format, BGR24>)
+    {
+        std::memcpy(out, row, static_cast<size_t>(width) * 3);
+    }
+    else
+    {
+        for (int32_t x = 0; x < width; ++x, row += Format::bytes_per_pixel, out += 3)
+        {
+            const std::array<unsigned char, 3> color = Format::unpack(row);
+            out[0] = color[2];
+            out[1] = color[1];
+            out[2] = color[0];
+        }
+    }
+}
+
+// Load font from .fnt file (shared with every other canvas using the same file)
+template <typename Format>
+bool BasicBMPImageCreator<Format>::loadFont(const std::string &filename)
+{
+    std::shared_ptr<const BMPFont> loaded = BMPFont::load(filename);
+    if (!loaded)
+        return false;
+
+    font = loaded;
+    return true;
+}
+
+// Draw text with loaded font
+template <typename Format>
+void BasicBMPImageCreator<Format>::drawText(int startX, int startY, const std::string &text, int r, int g, int b, int scale, bool wrap)
+{
+    if (!font && !loadFont(font_path))
+    {
+        std::cerr << "Fatal error: font file not found\n";
+        std::exit(1);
+        return;
+    }
+    const int char_height = font->getHeight();
+    const int spacing = font->getSpacing();
+    const Pixel pixel = packColor(r, g, b);
+
+    int current_x = startX;
+    int current_y = startY;
+    bool wrapped = false;
+
+    std::vector<std::string> words;
+    std::string cur;
+    for (char ch : text)
+    {
+        if (ch == '\n')
+        {
+            if (!cur.empty())
+            {
+                words.push_back(cur);
                 cur.clear();
             }
             words.push_back("\n");
@@ -342,85 +1637,346 @@ void BMPImageCreator::drawText(int startX, int startY, const std::string &text,
         if (word == "\n")
         {
             current_x = startX;
-            current_y += (char_height + 1) * scale;
+            current_y += (char_height + spacing) * scale;
             continue;
         }
 
+        // Words are split on ASCII bytes, so they stay valid UTF-8
         int word_width = 0;
-        for (char cc : word)
+        for (size_t pos = 0; pos < word.size();)
         {
-            unsigned char c = static_cast<unsigned char>(cc);
-            word_width += (cropped_chars[c].size() + 1) * scale;
+            if (const BMPFont::Glyph *glyph = font->findGlyph(BMPFont::decodeUTF8(word, pos)))
+                word_width += (glyph->advance + spacing) * scale;
         }
 
         wrapped = false;
         if (wrap && word_width > 0 && current_x + word_width > width && word_width <= width)
         {
             current_x = startX;
-            current_y += (char_height + 1) * scale;
+            current_y += (char_height + spacing) * scale;
             wrapped = true;
         }
 
-        for (char cc : word)
+        for (size_t pos = 0; pos < word.size();)
         {
-            unsigned char c = static_cast<unsigned char>(cc);
+            const uint32_t c = BMPFont::decodeUTF8(word, pos);
+            const BMPFont::Glyph *glyph = font->findGlyph(c);
 
-            if (c >= cropped_chars.size() || wrapped && c == 32 && current_x == startX)
+            if (!glyph || (wrapped && c == 32 && current_x == startX))
             {
                 continue;
             }
 
-            for (int cy = 0; cy < char_height; ++cy)
+            // Each run of set bits in a glyph row becomes one span per scaled row
+            const int glyph_width = glyph->width;
+            const int glyph_x = current_x + glyph->left * scale;
+            for (int cy = 0; cy < char_height && scale > 0; ++cy)
             {
-                for (int cx = 0; cx < cropped_chars[c].size(); ++cx)
+                const uint8_t *bits = font->glyphRow(*glyph, cy);
+                for (int cx = 0; cx < glyph_width;)
                 {
-                    if (!cropped_chars[c][cx][cy])
+                    if (!((bits[cx / 8] >> (7 - cx % 8)) & 1))
+                    {
+                        ++cx;
                         continue;
+                    }
+                    int run_end = cx + 1;
+                    while (run_end < glyph_width && ((bits[run_end / 8] >> (7 - run_end % 8)) & 1))
+                        ++run_end;
+
                     for (int dy = 0; dy < scale; ++dy)
                     {
-                        for (int dx = 0; dx < scale; ++dx)
-                        {
-                            int px = current_x + cx * scale + dx;
-                            int py = current_y + cy * scale + dy;
-                            setPixel(px, py, r, g, b);
-                        }
+                        fillSpan(glyph_x + cx * scale, glyph_x + run_end * scale - 1, current_y + cy * scale + dy, pixel);
                     }
+                    cx = run_end;
                 }
             }
 
-            current_x += (cropped_chars[c].size() + 1) * scale;
+            current_x += (glyph->advance + spacing) * scale;
+        }
+    }
+}
+
+// Total size of the encoded BMP in bytes
+template <typename Format>
+size_t BasicBMPImageCreator<Format>::encodedSize() const
+{
+    return file_size;
+}
+
+// Encode into a caller-provided buffer, returns bytes written (0 if capacity is too small)
+template <typename Format>
+size_t BasicBMPImageCreator<Format>::encodeToBuffer(unsigned char *buffer, size_t capacity) const
+{
+    const size_t size = encodedSize();
+    if (buffer == nullptr || capacity < size)
+    {
+        return 0;
+    }
+
+    std::memcpy(buffer, headers, pixel_info_offset);
+    std::copy(pixels.begin(), pixels.end(), buffer + pixel_info_offset);
+    return size;
+}
+
+// Encode into a reusable vector (keeps its capacity across calls)
+template <typename Format>
+void BasicBMPImageCreator<Format>::encodeToBuffer(std::vector<unsigned char> &buffer) const
+{
+    buffer.resize(encodedSize());
+    encodeToBuffer(buffer.data(), buffer.size());
+}
+
+// Encode into a new vector
+template <typename Format>
+std::vector<unsigned char> BasicBMPImageCreator<Format>::encodeToBuffer() const
+{
+    std::vector<unsigned char> buffer;
+    encodeToBuffer(buffer);
+    return buffer;
+}
+
+// Write the encoded image to an output stream
+template <typename Format>
+bool BasicBMPImageCreator<Format>::writeTo(std::ostream &out) const
+{
+    out.write(reinterpret_cast<const char *>(headers), pixel_info_offset);
+    out.write(reinterpret_cast<const char *>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    return static_cast<bool>(out);
+}
+
+// Write the encoded image to a callback in chunks of at most chunk_size bytes
+template <typename Format>
+bool BasicBMPImageCreator<Format>::writeTo(const std::function<bool(const unsigned char *, size_t)> &sink, size_t chunk_size) const
+{
+    if (!sink)
+    {
+        return false;
+    }
+    if (chunk_size == 0)
+    {
+        chunk_size = encodedSize();
+    }
+
+    // Headers go out as one chunk, pixel data is handed out directly from storage
+    if (!sink(headers, pixel_info_offset))
+    {
+        return false;
+    }
+
+    for (size_t offset = 0; offset < pixels.size(); offset += chunk_size)
+    {
+        const size_t length = std::min(chunk_size, pixels.size() - offset);
+        if (!sink(pixels.data() + offset, length))
+        {
+            return false;
         }
     }
+    return true;
+}
+
+// Prepare a stream over the encoded file
+template <typename Format>
+BasicBMPImageCreator<Format>::ByteStream::ByteStream(const BasicBMPImageCreator &image1) : image(&image1)
+{
+}
+
+// Produce headers, then rows in file order (bottom-up)
+template <typename Format>
+bool BasicBMPImageCreator<Format>::ByteStream::next(Chunk &chunk)
+{
+    if (next_row < 0)
+    {
+        chunk = {image->headers, pixel_info_offset};
+        next_row = 0;
+        return true;
+    }
+    if (next_row >= image->height)
+    {
+        return false;
+    }
+
+    chunk = {image->pixels.data() + static_cast<size_t>(next_row) * image->row_size, image->row_size};
+    ++next_row;
+    return true;
 }
 
-// Save image to file
-void BMPImageCreator::saveFile(const std::string &filename)
+// Open a pull-based stream over the encoded file
+template <typename Format>
+typename BasicBMPImageCreator<Format>::ByteStream BasicBMPImageCreator<Format>::stream() const
 {
-    std::vector<unsigned char> pixel_data(pixel_data_size, 0);
-    for (size_t y = 0; y < height; ++y)
+    return ByteStream(*this);
+}
+
+// Encode as QOI: top-down rows, RGB, every op chosen from the previous pixel and a 64-entry hash of seen colors
+template <typename Format>
+bool BasicBMPImageCreator<Format>::writeQOI(const std::function<bool(const unsigned char *, size_t)> &sink, size_t chunk_size) const
+{
+    constexpr unsigned char op_index = 0x00;
+    constexpr unsigned char op_diff = 0x40;
+    constexpr unsigned char op_luma = 0x80;
+    constexpr unsigned char op_run = 0xc0;
+    constexpr unsigned char op_rgb = 0xfe;
+    constexpr size_t max_op_size = 5;
+    constexpr int max_run = 62;
+
+    if (!sink)
+    {
+        return false;
+    }
+    chunk_size = std::max(chunk_size, static_cast<size_t>(64));
+
+    std::vector<unsigned char> buffer(chunk_size);
+    size_t used = 0;
+
+    // 14-byte header: magic, big-endian size, 3 channels, sRGB
+    const unsigned char header[14] = {
+        'q', 'o', 'i', 'f',
+        static_cast<unsigned char>(width >> 24), static_cast<unsigned char>(width >> 16),
+        static_cast<unsigned char>(width >> 8), static_cast<unsigned char>(width),
+        static_cast<unsigned char>(height >> 24), static_cast<unsigned char>(height >> 16),
+        static_cast<unsigned char>(height >> 8), static_cast<unsigned char>(height),
+        3, 0};
+    std::memcpy(buffer.data(), header, sizeof(header));
+    used = sizeof(header);
+
+    // RGBA like the decoder: slots start as (0, 0, 0, 0), which no opaque pixel can match
+    std::array<std::array<unsigned char, 4>, 64> seen{};
+    std::array<unsigned char, 4> previous = {0, 0, 0, 255};
+    int run = 0;
+
+    for (int32_t y = 0; y < height; ++y)
+    {
+        const unsigned char *row = rowData(y);
+        for (int32_t x = 0; x < width; ++x, row += Format::bytes_per_pixel)
+        {
+            // Room for a pending run plus the largest op
+            if (used + max_op_size + 1 > buffer.size())
+            {
+                if (!sink(buffer.data(), used))
+                {
+                    return false;
+                }
+                used = 0;
+            }
+
+            const std::array<unsigned char, 3> rgb = Format::unpack(row);
+            const std::array<unsigned char, 4> color = {rgb[0], rgb[1], rgb[2], 255};
+            if (color == previous)
+            {
+                if (++run == max_run)
+                {
+                    buffer[used++] = static_cast<unsigned char>(op_run | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0)
+            {
+                buffer[used++] = static_cast<unsigned char>(op_run | (run - 1));
+                run = 0;
+            }
+
+            const int hash = (color[0] * 3 + color[1] * 5 + color[2] * 7 + color[3] * 11) % 64;
+            if (seen[hash] == color)
+            {
+                buffer[used++] = static_cast<unsigned char>(op_index | hash);
+            }
+            else
+            {
+                seen[hash] = color;
+
+                const int dr = static_cast<signed char>(color[0] - previous[0]);
+                const int dg = static_cast<signed char>(color[1] - previous[1]);
+                const int db = static_cast<signed char>(color[2] - previous[2]);
+                const int dr_dg = dr - dg;
+                const int db_dg = db - dg;
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                {
+                    buffer[used++] = static_cast<unsigned char>(op_diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                }
+                else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+                {
+                    buffer[used++] = static_cast<unsigned char>(op_luma | (dg + 32));
+                    buffer[used++] = static_cast<unsigned char>((dr_dg + 8) << 4 | (db_dg + 8));
+                }
+                else
+                {
+                    buffer[used++] = op_rgb;
+                    buffer[used++] = color[0];
+                    buffer[used++] = color[1];
+                    buffer[used++] = color[2];
+                }
+            }
+            previous = color;
+        }
+    }
+
+    // Pending run plus the 8-byte end marker
+    if (used + 1 + 8 > buffer.size())
     {
-        size_t row_start = y * row_size;
-        const size_t src_y = height - 1 - y;
-        for (size_t x = 0; x < width; ++x)
+        if (!sink(buffer.data(), used))
         {
-            size_t i = row_start + x * 3;
-            const auto &rgb = pixels[src_y][x];
-            pixel_data[i + 0] = rgb[2];
-            pixel_data[i + 1] = rgb[1];
-            pixel_data[i + 2] = rgb[0];
+            return false;
         }
+        used = 0;
+    }
+    if (run > 0)
+    {
+        buffer[used++] = static_cast<unsigned char>(op_run | (run - 1));
     }
+    const unsigned char end_marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    std::memcpy(buffer.data() + used, end_marker, sizeof(end_marker));
+    used += sizeof(end_marker);
+    return sink(buffer.data(), used);
+}
+
+// Write the QOI encoding to an output stream
+template <typename Format>
+bool BasicBMPImageCreator<Format>::writeQOI(std::ostream &out) const
+{
+    return writeQOI([&out](const unsigned char *data, size_t size)
+                    { return static_cast<bool>(out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size))); });
+}
+
+// Encode as QOI into a new vector
+template <typename Format>
+std::vector<unsigned char> BasicBMPImageCreator<Format>::encodeQOI() const
+{
+    std::vector<unsigned char> buffer;
+    writeQOI([&buffer](const unsigned char *data, size_t size)
+             {
+        buffer.insert(buffer.end(), data, data + size);
+        return true; });
+    return buffer;
+}
 
-    std::string filename1 = filename + ".bmp";
+// Save image to file (<filename>.bmp or <filename>.qoi)
+template <typename Format>
+bool BasicBMPImageCreator<Format>::saveFile(const std::string &filename, BMPFileFormat format) const
+{
+    std::string filename1 = filename + (format == BMPFileFormat::QOI ? ".qoi" : ".bmp");
 
     std::ofstream file(filename1, std::ios::binary);
     if (!file)
     {
-        return;
+        return false;
     }
 
-    file.write(reinterpret_cast<char *>(file_header), sizeof(file_header));
-    file.write(reinterpret_cast<char *>(bitmap_info_header), sizeof(bitmap_info_header));
-    file.write(reinterpret_cast<char *>(pixel_data.data()), pixel_data_size);
+    bool written;
+    if (format == BMPFileFormat::QOI)
+    {
+        written = writeQOI(file);
+    }
+    else
+    {
+        written = writeTo(file);
+    }
     file.close();
-}
\ No newline at end of file
+    return written && !file.fail();
+}
+
+template class BasicBMPImageCreator<BGR24>;
+template class BasicBMPImageCreator<BGRA32>;
+template class BasicBMPImageCreator<Gray8>;
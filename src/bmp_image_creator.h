@@ -5,53 +5,341 @@
 #include <vector>
 #include <array>
 #include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <functional>
+#include <iterator>
+#include <memory>
 
-class BMPImageCreator
+#include "bmp_pixel_formats.h"
+#include "bmp_font.h"
+
+// Integer point for path/shape functions
+struct BMPPoint
+{
+    int32_t x;
+    int32_t y;
+};
+
+// Polygon with its own color, for batch filling
+struct BMPPolygon
+{
+    std::vector<BMPPoint> points;
+    int r;
+    int g;
+    int b;
+};
+
+// Which points count as inside a (possibly self-intersecting) polygon
+enum class BMPFillRule
+{
+    EvenOdd,
+    NonZero
+};
+
+// Color gradient for the *Gradient fill functions. Linear runs from (x0,y0) to (x1,y1),
+// radial from the center (x0,y0) out to radius. Stops are positions 0..1, colors beyond the ends are padded.
+struct BMPGradientStop
 {
+    float position;
+    int r;
+    int g;
+    int b;
+};
+
+struct BMPGradient
+{
+    enum class Type
+    {
+        Linear,
+        Radial
+    };
+
+    Type type = Type::Linear;
+    int32_t x0 = 0;
+    int32_t y0 = 0;
+    int32_t x1 = 0;
+    int32_t y1 = 0;
+    int32_t radius = 0;
+    std::vector<BMPGradientStop> stops;
+
+    static BMPGradient linear(int32_t x0, int32_t y0, int32_t x1, int32_t y1, std::vector<BMPGradientStop> stops)
+    {
+        return {Type::Linear, x0, y0, x1, y1, 0, std::move(stops)};
+    }
+
+    static BMPGradient radial(int32_t centerX, int32_t centerY, int32_t radius, std::vector<BMPGradientStop> stops)
+    {
+        return {Type::Radial, centerX, centerY, 0, 0, radius, std::move(stops)};
+    }
+};
+
+// Resampling filters for resized()
+enum class BMPResampleFilter
+{
+    Nearest,
+    Bilinear,
+    Area
+};
+
+// Stroke styles for thick lines and polylines
+enum class BMPLineJoin
+{
+    Miter,
+    Round,
+    Bevel
+};
+
+enum class BMPLineCap
+{
+    Butt,
+    Round,
+    Square
+};
+
+// Container written by saveFile
+enum class BMPFileFormat
+{
+    BMP, // uncompressed, <filename>.bmp
+    QOI  // lossless "Quite OK Image" compression, <filename>.qoi
+};
+
+// Canvas specialized at compile time on a pixel format policy (see bmp_pixel_formats.h)
+template <typename Format>
+class BasicBMPImageCreator
+{
+    // Other formats use each other as scratch canvases (e.g. a Gray8 shadow mask)
+    template <typename>
+    friend class BasicBMPImageCreator;
+
+public:
+    // font path used until loadFont is called (change if you're using it outside the repo)
+    static constexpr const char *default_font_path = "src/font.fnt";
+
 private:
-    // font path (change if you're using it outside the repo)
-    std::string font_path = "src/font.fnt";
+    using Pixel = typename Format::Pixel;
+
+    std::string font_path = default_font_path;
 
     // Constants for BMP format
     static constexpr short file_header_size = 14;
     static constexpr short bitmap_info_header_size = 40;
-    static constexpr short pixel_info_offset = file_header_size + bitmap_info_header_size;
+    static constexpr short palette_bytes = Format::palette_size * 4;
+    static constexpr short pixel_info_offset = file_header_size + bitmap_info_header_size + palette_bytes;
 
-    // BMP file header and DIB header
-    unsigned char file_header[14] = {0};
-    unsigned char bitmap_info_header[40] = {0};
+    // BMP file header, DIB header and color table, kept contiguous so they can be written in one go
+    unsigned char headers[pixel_info_offset] = {0};
 
-    // Image dimensions and properties
+    // Image dimensions and properties (byte counts are 64-bit on 64-bit targets)
     int32_t width;
     int32_t height;
-    int32_t padding_size;
-    int32_t row_size;
-    int32_t pixel_data_size;
-    int32_t file_size;
+    size_t padding_size;
+    size_t row_size;
+    size_t pixel_data_size;
+    size_t file_size;
+
+    // bfSize and biSizeImage are unsigned 32-bit, so the whole file has to stay below 4 GiB
+    static constexpr uint64_t max_file_size = UINT32_MAX;
 
     // DIB header constants
-    static constexpr int32_t bits_per_pixel = 24;
+    static constexpr int32_t bits_per_pixel = Format::bits_per_pixel;
     static constexpr int32_t color_planes = 1;
     static constexpr int32_t compression = 0;
     static constexpr int32_t resolution = 2835;
-    static constexpr int32_t colors_used = 0;
+    static constexpr int32_t colors_used = Format::palette_size;
     static constexpr int32_t important_colors = 0;
 
-    // Pixel data
-    std::vector<std::vector<std::array<unsigned char, 3>>> pixels;
+    // Pixel data, stored exactly as it appears in the file (bottom-up, padded rows)
+    std::vector<unsigned char> pixels;
+
+    // Byte offset of pixel (x,y) inside pixels (y = 0 is the top row)
+    size_t pixelOffset(int32_t x, int32_t y) const
+    {
+        return static_cast<size_t>(height - 1 - y) * row_size + static_cast<size_t>(x) * Format::bytes_per_pixel;
+    }
+
+    // Start of row y (y = 0 is the top row)
+    unsigned char *rowData(int32_t y) { return pixels.data() + static_cast<size_t>(height - 1 - y) * row_size; }
+    const unsigned char *rowData(int32_t y) const { return pixels.data() + static_cast<size_t>(height - 1 - y) * row_size; }
+
+    // Write width, height and the byte sizes into headers
+    void writeGeometry();
+
+    // Pack a clamped color into the stored pixel layout
+    static Pixel packColor(int r, int g, int b);
+
+    // Fill pixels x0..x1 (inclusive) of row y, clipped to the canvas
+    void fillSpan(int32_t x0, int32_t x1, int32_t y, const Pixel &pixel);
+
+    // Fill pixels y0..y1 (inclusive) of column x, clipped to the canvas
+    void fillColumn(int32_t x, int32_t y0, int32_t y1, const Pixel &pixel);
+
+    // Keeps the running sums (255 * (2 * radius + 1)) within 32 bits and the rounded reciprocal exact to a quarter LSB
+    static constexpr int max_blur_radius = 1 << 22;
+
+    // One running-sum box pass over the (already clipped) rectangle
+    void boxBlurRows(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned threads);
+    void boxBlurColumns(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned threads);
+
+    // Blend a pixel over (x,y) with coverage 0..256 (256 = opaque), clipped to the canvas
+    void blendPixel(int32_t x, int32_t y, const Pixel &pixel, uint32_t coverage);
 
-    // Font variables
-    bool font_loaded = false;
-    const int char_width = 8;
-    const int char_height = 8;
-    const int char_quantity = 128;
-    std::vector<std::vector<std::vector<bool>>> font_chars;
-    std::vector<std::vector<std::vector<bool>>> cropped_chars;
-    std::vector<int> cropped_char_widths;
+    // Gradient prepared for span filling: a color table indexed in 16.16 fixed point
+    struct GradientSpans
+    {
+        static constexpr int32_t lut_size = 1024;
+
+        bool radial = false;
+        int32_t x0 = 0;
+        int32_t y0 = 0;
+        double step_x = 0.0; // linear: table index change per pixel along x
+        double step_y = 0.0; // linear: table index change per row
+        double scale = 0.0;  // radial: table index per pixel of distance
+        std::vector<Pixel> lut;
+    };
+
+    // While set, fillSpan paints this gradient instead of its solid pixel
+    GradientSpans gradient_scratch;
+    const GradientSpans *span_gradient = nullptr;
+
+    // Build gradient_scratch from a gradient description (false if it has no stops)
+    bool prepareGradient(const BMPGradient &gradient);
+
+    // Write the active gradient over pixels x0..x1 (already clipped) of row y
+    void gradientSpan(int32_t x0, int32_t x1, int32_t y);
+
+    // Horizontal run of pixels x0..x1 on row y
+    struct Span
+    {
+        int32_t y;
+        int32_t x0;
+        int32_t x1;
+    };
+
+    struct PointF
+    {
+        double x;
+        double y;
+    };
+
+    // Spans collected by shape functions before filling, and a path buffer (both reused between calls)
+    std::vector<Span> span_scratch;
+    std::vector<PointF> path_scratch;
+
+    // Polygon edge for the scanline filler, stepped exactly with an integer DDA
+    struct Edge
+    {
+        int32_t y_start; // first row crossed
+        int32_t y_end;   // first row no longer crossed
+        int32_t dir;     // +1 downwards, -1 upwards (winding)
+        int64_t x;       // floor of the crossing on the current row
+        int64_t rem;     // remainder of the crossing, 0 <= rem < dy
+        int64_t x_step;
+        int64_t rem_step;
+        int64_t dy;
+
+        int64_t crossing() const { return x + (rem > 0 ? 1 : 0); }
+    };
+
+    // Edge table and active edge list (reused between calls)
+    std::vector<Edge> edge_scratch;
+    std::vector<Edge> active_scratch;
+
+    // Scanline fill of one polygon
+    void scanPolygon(const BMPPoint *points, size_t count, const Pixel &pixel, BMPFillRule rule);
+
+    // Stroke a path given as count points
+    void strokePath(const BMPPoint *points, size_t count, int thickness, const Pixel &pixel, BMPLineJoin join, BMPLineCap cap);
+
+    // Add the spans covered by a convex polygon / a disc to span_scratch
+    void addConvexSpans(const PointF *points, int count);
+    void addDiscSpans(double centerX, double centerY, double radius);
+
+    // Merge the collected spans per row and fill each covered pixel exactly once
+    void fillCollectedSpans(const Pixel &pixel);
+
+    // Blend (cx +- dx, cy +- dy) without touching the same pixel twice (64-bit so huge circles can't overflow)
+    void blendMirrored(int64_t cx, int64_t cy, int64_t dx, int64_t dy, const Pixel &pixel, uint32_t coverage);
+
+    // Font (shared between canvases, loaded on first drawText)
+    std::shared_ptr<const BMPFont> font;
 
 public:
-    // Constructor
-    BMPImageCreator(int32_t width, int32_t height);
+    // Pull-based view of the encoded file: headers first, then one padded row per chunk in file order.
+    // Rows point straight into the canvas, which must outlive the stream and stay unmodified while reading.
+    class ByteStream
+    {
+    public:
+        struct Chunk
+        {
+            const unsigned char *data;
+            size_t size;
+        };
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Chunk;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Chunk *;
+            using reference = const Chunk &;
+
+            iterator() = default;
+            explicit iterator(ByteStream *stream) : stream(stream)
+            {
+                ++*this;
+            }
+
+            reference operator*() const { return chunk; }
+            pointer operator->() const { return &chunk; }
+            iterator &operator++()
+            {
+                if (stream && !stream->next(chunk))
+                    stream = nullptr;
+                return *this;
+            }
+            void operator++(int) { ++*this; }
+            bool operator==(const iterator &other) const { return stream == other.stream; }
+            bool operator!=(const iterator &other) const { return stream != other.stream; }
+
+        private:
+            ByteStream *stream = nullptr;
+            Chunk chunk{nullptr, 0};
+        };
+
+        explicit ByteStream(const BasicBMPImageCreator &image);
+
+        // Fetch the next chunk, returns false once the whole file has been produced
+        bool next(Chunk &chunk);
+
+        iterator begin() { return iterator(this); }
+        iterator end() { return iterator(); }
+
+    private:
+        const BasicBMPImageCreator *image;
+        int32_t next_row = -1;
+    };
+
+    // Constructor (non-positive sizes fall back to a 10x5 canvas; sizes whose file would not fit the
+    // 32-bit BMP size fields throw std::length_error, as reset does)
+    BasicBMPImageCreator(int32_t width, int32_t height);
+    // Copy and move (a moved-from canvas is empty, 0x0, and ignores drawing)
+    BasicBMPImageCreator(const BasicBMPImageCreator &) = default;
+    BasicBMPImageCreator(BasicBMPImageCreator &&other) noexcept;
+    BasicBMPImageCreator &operator=(const BasicBMPImageCreator &) = default;
+    BasicBMPImageCreator &operator=(BasicBMPImageCreator &&other) noexcept;
+
+    // Resize and clear to white, reusing the existing pixel storage when it is large enough
+    // (throws std::length_error, leaving the canvas unchanged, for positive sizes rejected by validSize)
+    void reset(int32_t width, int32_t height);
+
+    // Whether a width x height canvas is positive and its file fits the 32-bit BMP size fields
+    static bool validSize(int32_t width, int32_t height);
+
+    // Dimensions
+    int32_t getWidth() const { return width; }
+    int32_t getHeight() const { return height; }
 
     // Drawing functions
     void setDefaultPixelRGB(int r, int g, int b);
@@ -61,11 +349,83 @@ public:
     void drawCircle(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill);
     void drawText(int startX, int startY, const std::string &text, int r, int g, int b, int scale, bool wrap);
 
-    // Font loader
+    // Anti-aliased drawing functions (fixed-point coverage blended over the existing pixels)
+    void drawLineAA(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b);
+    void drawCircleAA(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill);
+
+    // Polygon fill (concave and self-intersecting outlines allowed); adjacent polygons sharing an edge never overlap
+    void fillPolygon(const std::vector<BMPPoint> &points, int r, int g, int b, BMPFillRule rule = BMPFillRule::NonZero);
+    void fillPolygons(const std::vector<BMPPolygon> &polygons, BMPFillRule rule = BMPFillRule::NonZero);
+
+    // Flood fill the 4-connected region of pixels matching the one at (x,y)
+    void floodFill(int32_t x, int32_t y, int r, int g, int b);
+
+    // Gradient fills (linear / radial, multi-stop), computed incrementally per span
+    void fillRectangleGradient(int32_t x, int32_t y, int32_t x1, int32_t y1, const BMPGradient &gradient);
+    void fillCircleGradient(int32_t centerX, int32_t centerY, int32_t radius, const BMPGradient &gradient);
+    void fillPolygonGradient(const std::vector<BMPPoint> &points, const BMPGradient &gradient, BMPFillRule rule = BMPFillRule::NonZero);
+
+    // Time series: samples spread evenly over x0..x1, min_value..max_value mapped to y1..y0.
+    // Reduced to min/max/first/last per pixel column, so the cost depends on the width, not the sample count.
+    void drawSeries(const float *samples, size_t count, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                    float min_value, float max_value, int r, int g, int b);
+
+    // Thick strokes, rasterized as merged spans (no pixel is written twice)
+    void drawThickLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int thickness, int r, int g, int b,
+                       BMPLineCap cap = BMPLineCap::Butt);
+    void drawPolyline(const std::vector<BMPPoint> &points, int thickness, int r, int g, int b,
+                      BMPLineJoin join = BMPLineJoin::Miter, BMPLineCap cap = BMPLineCap::Butt);
+
+    // Resampling into a new canvas (row bands are split across threads when threads > 1)
+    BasicBMPImageCreator resized(int32_t new_width, int32_t new_height, BMPResampleFilter filter = BMPResampleFilter::Area,
+                                 unsigned threads = 1) const;
+    BasicBMPImageCreator resolve(int factor, unsigned threads = 1) const;
+
+    // Separable blur filters, in place on the whole canvas or the rectangle x0..x1 / y0..y1
+    void boxBlur(int radius, unsigned threads = 1);
+    void boxBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned threads = 1);
+    void gaussianBlur(float sigma, unsigned threads = 1);
+    void gaussianBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, float sigma, unsigned threads = 1);
+
+    // Soft shadow of the rectangle x0..x1 / y0..y1, blurred by blur_radius and blended at opacity (0..255)
+    void drawShadow(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int blur_radius, int r, int g, int b, int opacity);
+
+    // Copy row y (0 = top) as tightly packed RGB or BGR bytes, width * 3 of them
+    void readRowRGB(int32_t y, unsigned char *out) const;
+    void readRowBGR(int32_t y, unsigned char *out) const;
+
+    // Font loader (.fnt, PSF2 or BDF, detected from the file contents)
     bool loadFont(const std::string &filename);
 
+    // Encoding
+    size_t encodedSize() const;
+    size_t encodeToBuffer(unsigned char *buffer, size_t capacity) const;
+    void encodeToBuffer(std::vector<unsigned char> &buffer) const;
+    std::vector<unsigned char> encodeToBuffer() const;
+
+    // Stream output (sink returns false to abort)
+    bool writeTo(std::ostream &out) const;
+    bool writeTo(const std::function<bool(const unsigned char *, size_t)> &sink, size_t chunk_size = 65536) const;
+
+    // Streaming output
+    ByteStream stream() const;
+
+    // QOI output (one pass over the canvas, sink gets chunks of at most chunk_size bytes)
+    bool writeQOI(const std::function<bool(const unsigned char *, size_t)> &sink, size_t chunk_size = 65536) const;
+    bool writeQOI(std::ostream &out) const;
+    std::vector<unsigned char> encodeQOI() const;
+
     // File output
-    void saveFile(const std::string &filename);
+    bool saveFile(const std::string &filename, BMPFileFormat format = BMPFileFormat::BMP) const;
 };
 
+// The classic 24-bit canvas, plus the other built-in formats
+using BMPImageCreator = BasicBMPImageCreator<BGR24>;
+using BMPImageCreatorBGRA = BasicBMPImageCreator<BGRA32>;
+using BMPImageCreatorGray = BasicBMPImageCreator<Gray8>;
+
+extern template class BasicBMPImageCreator<BGR24>;
+extern template class BasicBMPImageCreator<BGRA32>;
+extern template class BasicBMPImageCreator<Gray8>;
+
 #endif // BMP_IMAGE_CREATOR_H
@@ -0,0 +1,86 @@
+#ifndef BMP_PIXEL_FORMATS_H
+#define BMP_PIXEL_FORMATS_H
+
+#include <array>
+#include <cstdint>
+
+// Pixel format policies for BasicBMPImageCreator.
+// Each policy fixes the stored byte layout of one pixel, the matching BMP header values and
+// the color table (if any). Every stored byte is a linear intensity channel, so blending and
+// filter kernels can treat a row as a flat array of bytes_per_pixel-strided channels.
+
+// 24-bit BGR (the classic format)
+struct BGR24
+{
+    static constexpr int32_t bytes_per_pixel = 3;
+    static constexpr int32_t bits_per_pixel = 24;
+    static constexpr int32_t palette_size = 0;
+
+    using Pixel = std::array<unsigned char, bytes_per_pixel>;
+
+    static Pixel pack(unsigned char r, unsigned char g, unsigned char b)
+    {
+        return {b, g, r};
+    }
+
+    static std::array<unsigned char, 3> unpack(const unsigned char *p)
+    {
+        return {p[2], p[1], p[0]};
+    }
+
+    static void paletteEntry(int, unsigned char *) {}
+};
+
+// 32-bit BGRX (alpha byte is written as 255 and ignored by readers)
+struct BGRA32
+{
+    static constexpr int32_t bytes_per_pixel = 4;
+    static constexpr int32_t bits_per_pixel = 32;
+    static constexpr int32_t palette_size = 0;
+
+    using Pixel = std::array<unsigned char, bytes_per_pixel>;
+
+    static Pixel pack(unsigned char r, unsigned char g, unsigned char b)
+    {
+        return {b, g, r, 255};
+    }
+
+    static std::array<unsigned char, 3> unpack(const unsigned char *p)
+    {
+        return {p[2], p[1], p[0]};
+    }
+
+    static void paletteEntry(int, unsigned char *) {}
+};
+
+// 8-bit grayscale (stored as an 8-bit BMP with an identity gray palette)
+struct Gray8
+{
+    static constexpr int32_t bytes_per_pixel = 1;
+    static constexpr int32_t bits_per_pixel = 8;
+    static constexpr int32_t palette_size = 256;
+
+    using Pixel = std::array<unsigned char, bytes_per_pixel>;
+
+    // Rec. 601 luma in 8-bit fixed point
+    static Pixel pack(unsigned char r, unsigned char g, unsigned char b)
+    {
+        return {static_cast<unsigned char>((77 * r + 150 * g + 29 * b) >> 8)};
+    }
+
+    static std::array<unsigned char, 3> unpack(const unsigned char *p)
+    {
+        return {p[0], p[0], p[0]};
+    }
+
+    // Palette entries are BGR0
+    static void paletteEntry(int index, unsigned char *entry)
+    {
+        entry[0] = static_cast<unsigned char>(index);
+        entry[1] = static_cast<unsigned char>(index);
+        entry[2] = static_cast<unsigned char>(index);
+        entry[3] = 0;
+    }
+};
+
+#endif // BMP_PIXEL_FORMATS_H
@@ -0,0 +1,581 @@
+#include "bmp_render_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+
+// FNV-1a 64-bit parameters
+static constexpr uint64_t fnv_offset_basis = 14695981039346656037ULL;
+static constexpr uint64_t fnv_prime = 1099511628211ULL;
+
+// Rebuild a point list stored as x,y pairs from args[first] on
+static std::vector<BMPPoint> toPoints(const std::vector<int32_t> &args, size_t first)
+{
+    std::vector<BMPPoint> points;
+    for (size_t i = first; i + 1 < args.size(); i += 2)
+    {
+        points.push_back({args[i], args[i + 1]});
+    }
+    return points;
+}
+
+// Append a gradient as type, x0, y0, x1, y1, radius, stop count, then position bits, r, g, b per stop
+static void appendGradient(std::vector<int32_t> &args, const BMPGradient &gradient)
+{
+    args.insert(args.end(), {static_cast<int32_t>(gradient.type), gradient.x0, gradient.y0, gradient.x1, gradient.y1,
+                             gradient.radius, static_cast<int32_t>(gradient.stops.size())});
+    for (const BMPGradientStop &stop : gradient.stops)
+    {
+        int32_t position_bits;
+        std::memcpy(&position_bits, &stop.position, sizeof(position_bits));
+        args.insert(args.end(), {position_bits, stop.r, stop.g, stop.b});
+    }
+}
+
+// Read a gradient written by appendGradient at args[index], advancing index past it
+static BMPGradient readGradient(const std::vector<int32_t> &args, size_t &index)
+{
+    BMPGradient gradient;
+    gradient.type = static_cast<BMPGradient::Type>(args[index]);
+    gradient.x0 = args[index + 1];
+    gradient.y0 = args[index + 2];
+    gradient.x1 = args[index + 3];
+    gradient.y1 = args[index + 4];
+    gradient.radius = args[index + 5];
+    const int32_t count = args[index + 6];
+    index += 7;
+    for (int32_t i = 0; i < count; ++i, index += 4)
+    {
+        BMPGradientStop stop;
+        std::memcpy(&stop.position, &args[index], sizeof(stop.position));
+        stop.r = args[index + 1];
+        stop.g = args[index + 2];
+        stop.b = args[index + 3];
+        gradient.stops.push_back(stop);
+    }
+    return gradient;
+}
+
+// Constructor
+BMPDrawRecorder::BMPDrawRecorder(int32_t width1, int32_t height1)
+{
+    reset(width1, height1);
+}
+
+// Start over with a new canvas size
+void BMPDrawRecorder::reset(int32_t width1, int32_t height1)
+{
+    width = width1;
+    height = height1;
+    commands.clear();
+    key_bytes.clear();
+    font_hash_known = false;
+    hash_value = fnv_offset_basis;
+    appendKey(&key_version, sizeof(key_version));
+    appendKey(&width, sizeof(width));
+    appendKey(&height, sizeof(height));
+}
+
+// Append bytes to the key and fold them into the running hash
+void BMPDrawRecorder::appendKey(const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    key_bytes.insert(key_bytes.end(), bytes, bytes + size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash_value ^= bytes[i];
+        hash_value *= fnv_prime;
+    }
+}
+
+// Store a call and fold it into the key
+void BMPDrawRecorder::record(Op op, std::vector<int32_t> args, const std::string &text)
+{
+    const uint8_t op_byte = static_cast<uint8_t>(op);
+    const uint32_t arg_count = static_cast<uint32_t>(args.size());
+    const uint32_t text_size = static_cast<uint32_t>(text.size());
+    appendKey(&op_byte, sizeof(op_byte));
+    appendKey(&arg_count, sizeof(arg_count));
+    appendKey(args.data(), args.size() * sizeof(int32_t));
+    appendKey(&text_size, sizeof(text_size));
+    appendKey(text.data(), text.size());
+
+    commands.push_back({op, std::move(args), text});
+}
+
+void BMPDrawRecorder::setDefaultPixelRGB(int r, int g, int b)
+{
+    record(Op::DefaultPixel, {r, g, b});
+}
+
+void BMPDrawRecorder::setPixel(int32_t x, int32_t y, int r, int g, int b)
+{
+    record(Op::Pixel, {x, y, r, g, b});
+}
+
+void BMPDrawRecorder::drawRectangle(int32_t x, int32_t y, int32_t x1, int32_t y1, int r, int g, int b, bool fill)
+{
+    record(Op::Rectangle, {x, y, x1, y1, r, g, b, fill});
+}
+
+void BMPDrawRecorder::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b)
+{
+    record(Op::Line, {x0, y0, x1, y1, r, g, b});
+}
+
+void BMPDrawRecorder::drawCircle(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill)
+{
+    record(Op::Circle, {centerX, centerY, radius, r, g, b, fill});
+}
+
+// Text also depends on the font that replay() will load, so the font's content hash goes into the key
+void BMPDrawRecorder::drawText(int startX, int startY, const std::string &text, int r, int g, int b, int scale, bool wrap)
+{
+    if (!font_hash_known)
+    {
+        std::shared_ptr<const BMPFont> font = BMPFont::load(BMPImageCreator::default_font_path);
+        font_hash = font ? font->contentHash() : 0;
+        font_hash_known = true;
+    }
+    appendKey(&font_hash, sizeof(font_hash));
+    record(Op::Text, {startX, startY, r, g, b, scale, wrap}, text);
+}
+
+void BMPDrawRecorder::drawLineAA(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b)
+{
+    record(Op::LineAA, {x0, y0, x1, y1, r, g, b});
+}
+
+void BMPDrawRecorder::drawCircleAA(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill)
+{
+    record(Op::CircleAA, {centerX, centerY, radius, r, g, b, fill});
+}
+
+void BMPDrawRecorder::fillPolygon(const std::vector<BMPPoint> &points, int r, int g, int b, BMPFillRule rule)
+{
+    std::vector<int32_t> args = {r, g, b, static_cast<int32_t>(rule)};
+    for (const BMPPoint &p : points)
+    {
+        args.push_back(p.x);
+        args.push_back(p.y);
+    }
+    record(Op::Polygon, std::move(args));
+}
+
+void BMPDrawRecorder::fillPolygons(const std::vector<BMPPolygon> &polygons, BMPFillRule rule)
+{
+    for (const BMPPolygon &polygon : polygons)
+    {
+        fillPolygon(polygon.points, polygon.r, polygon.g, polygon.b, rule);
+    }
+}
+
+void BMPDrawRecorder::floodFill(int32_t x, int32_t y, int r, int g, int b)
+{
+    record(Op::FloodFill, {x, y, r, g, b});
+}
+
+void BMPDrawRecorder::fillRectangleGradient(int32_t x, int32_t y, int32_t x1, int32_t y1, const BMPGradient &gradient)
+{
+    std::vector<int32_t> args = {x, y, x1, y1};
+    appendGradient(args, gradient);
+    record(Op::GradientRectangle, std::move(args));
+}
+
+void BMPDrawRecorder::fillCircleGradient(int32_t centerX, int32_t centerY, int32_t radius, const BMPGradient &gradient)
+{
+    std::vector<int32_t> args = {centerX, centerY, radius};
+    appendGradient(args, gradient);
+    record(Op::GradientCircle, std::move(args));
+}
+
+void BMPDrawRecorder::fillPolygonGradient(const std::vector<BMPPoint> &points, const BMPGradient &gradient, BMPFillRule rule)
+{
+    std::vector<int32_t> args = {static_cast<int32_t>(rule)};
+    appendGradient(args, gradient);
+    for (const BMPPoint &p : points)
+    {
+        args.push_back(p.x);
+        args.push_back(p.y);
+    }
+    record(Op::GradientPolygon, std::move(args));
+}
+
+void BMPDrawRecorder::drawThickLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int thickness, int r, int g, int b,
+                                    BMPLineCap cap)
+{
+    record(Op::ThickLine, {x0, y0, x1, y1, thickness, r, g, b, static_cast<int32_t>(cap)});
+}
+
+void BMPDrawRecorder::drawPolyline(const std::vector<BMPPoint> &points, int thickness, int r, int g, int b,
+                                   BMPLineJoin join, BMPLineCap cap)
+{
+    std::vector<int32_t> args = {thickness, r, g, b, static_cast<int32_t>(join), static_cast<int32_t>(cap)};
+    for (const BMPPoint &p : points)
+    {
+        args.push_back(p.x);
+        args.push_back(p.y);
+    }
+    record(Op::Polyline, std::move(args));
+}
+
+// Whole-canvas filters are recorded without a rectangle, so they replay on the canvas as created
+void BMPDrawRecorder::boxBlur(int radius, unsigned)
+{
+    record(Op::BoxBlur, {radius});
+}
+
+void BMPDrawRecorder::boxBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned)
+{
+    record(Op::BoxBlur, {radius, x0, y0, x1, y1});
+}
+
+// Sigma is stored as its float bits, like gradient stop positions
+void BMPDrawRecorder::gaussianBlur(float sigma, unsigned)
+{
+    int32_t sigma_bits;
+    std::memcpy(&sigma_bits, &sigma, sizeof(sigma_bits));
+    record(Op::GaussianBlur, {sigma_bits});
+}
+
+void BMPDrawRecorder::gaussianBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, float sigma, unsigned)
+{
+    int32_t sigma_bits;
+    std::memcpy(&sigma_bits, &sigma, sizeof(sigma_bits));
+    record(Op::GaussianBlur, {sigma_bits, x0, y0, x1, y1});
+}
+
+void BMPDrawRecorder::drawShadow(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int blur_radius, int r, int g, int b, int opacity)
+{
+    record(Op::Shadow, {x0, y0, x1, y1, blur_radius, r, g, b, opacity});
+}
+
+// Run the recorded calls on a canvas
+void BMPDrawRecorder::replay(BMPImageCreator &image) const
+{
+    for (const Command &cmd : commands)
+    {
+        const std::vector<int32_t> &a = cmd.args;
+        switch (cmd.op)
+        {
+        case Op::DefaultPixel:
+            image.setDefaultPixelRGB(a[0], a[1], a[2]);
+            break;
+        case Op::Pixel:
+            image.setPixel(a[0], a[1], a[2], a[3], a[4]);
+            break;
+        case Op::Rectangle:
+            image.drawRectangle(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7] != 0);
+            break;
+        case Op::Line:
+            image.drawLine(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+            break;
+        case Op::Circle:
+            image.drawCircle(a[0], a[1], a[2], a[3], a[4], a[5], a[6] != 0);
+            break;
+        case Op::Text:
+            image.drawText(a[0], a[1], cmd.text, a[2], a[3], a[4], a[5], a[6] != 0);
+            break;
+        case Op::LineAA:
+            image.drawLineAA(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+            break;
+        case Op::CircleAA:
+            image.drawCircleAA(a[0], a[1], a[2], a[3], a[4], a[5], a[6] != 0);
+            break;
+        case Op::ThickLine:
+            image.drawThickLine(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], static_cast<BMPLineCap>(a[8]));
+            break;
+        case Op::Polygon:
+            image.fillPolygon(toPoints(a, 4), a[0], a[1], a[2], static_cast<BMPFillRule>(a[3]));
+            break;
+        case Op::FloodFill:
+            image.floodFill(a[0], a[1], a[2], a[3], a[4]);
+            break;
+        case Op::GradientRectangle:
+        {
+            size_t index = 4;
+            image.fillRectangleGradient(a[0], a[1], a[2], a[3], readGradient(a, index));
+            break;
+        }
+        case Op::GradientCircle:
+        {
+            size_t index = 3;
+            image.fillCircleGradient(a[0], a[1], a[2], readGradient(a, index));
+            break;
+        }
+        case Op::GradientPolygon:
+        {
+            size_t index = 1;
+            const BMPGradient gradient = readGradient(a, index);
+            image.fillPolygonGradient(toPoints(a, index), gradient, static_cast<BMPFillRule>(a[0]));
+            break;
+        }
+        case Op::Polyline:
+            image.drawPolyline(toPoints(a, 6), a[0], a[1], a[2], a[3], static_cast<BMPLineJoin>(a[4]), static_cast<BMPLineCap>(a[5]));
+            break;
+        case Op::BoxBlur:
+            if (a.size() == 1)
+                image.boxBlur(a[0]);
+            else
+                image.boxBlur(a[1], a[2], a[3], a[4], a[0]);
+            break;
+        case Op::GaussianBlur:
+        {
+            float sigma;
+            std::memcpy(&sigma, &a[0], sizeof(sigma));
+            if (a.size() == 1)
+                image.gaussianBlur(sigma);
+            else
+                image.gaussianBlur(a[1], a[2], a[3], a[4], sigma);
+            break;
+        }
+        case Op::Shadow:
+            image.drawShadow(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8]);
+            break;
+        }
+    }
+}
+
+// Constructor: index the files already in the directory, oldest first, then trim to the limit
+BMPRenderCache::BMPRenderCache(size_t max_entries1, const std::string &directory1, size_t max_disk_entries1)
+    : max_entries(max_entries1 == 0 ? 1 : max_entries1), directory(directory1),
+      max_disk_entries(max_disk_entries1 == 0 ? 1 : max_disk_entries1)
+{
+    if (directory.empty())
+    {
+        return;
+    }
+
+    std::vector<std::pair<std::filesystem::file_time_type, uint64_t>> found;
+    std::error_code error;
+    for (const auto &item : std::filesystem::directory_iterator(directory, error))
+    {
+        const std::string name = item.path().filename().string();
+        if (name.size() != 20 || name.compare(16, 4, ".bmp") != 0 ||
+            name.find_first_not_of("0123456789abcdef") < 16)
+        {
+            continue;
+        }
+
+        std::error_code time_error;
+        const auto time = item.last_write_time(time_error);
+        if (!time_error)
+        {
+            found.emplace_back(time, std::stoull(name.substr(0, 16), nullptr, 16));
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    for (const auto &file : found)
+    {
+        touchDiskLocked(file.second);
+    }
+}
+
+// File name used for a hash in the disk cache
+std::string BMPRenderCache::diskPath(uint64_t hash) const
+{
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return directory + "/" + name + ".bmp";
+}
+
+// Put a buffer at the front of the LRU list, evicting the oldest entry if full
+BMPRenderCache::Buffer BMPRenderCache::insertLocked(uint64_t hash, const std::vector<unsigned char> &key, Buffer buffer)
+{
+    auto it = index.find(hash);
+    if (it != index.end())
+    {
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    entries.push_front({hash, key, buffer});
+    index[hash] = entries.begin();
+
+    if (entries.size() > max_entries)
+    {
+        index.erase(entries.back().hash);
+        entries.pop_back();
+    }
+    return buffer;
+}
+
+// Mark a disk entry as most recently used, deleting the least recently used files past the limit
+void BMPRenderCache::touchDiskLocked(uint64_t hash)
+{
+    auto it = disk_index.find(hash);
+    if (it != disk_index.end())
+    {
+        disk_entries.splice(disk_entries.begin(), disk_entries, it->second);
+        return;
+    }
+
+    disk_entries.push_front(hash);
+    disk_index[hash] = disk_entries.begin();
+
+    while (disk_entries.size() > max_disk_entries)
+    {
+        std::error_code error;
+        std::filesystem::remove(diskPath(disk_entries.back()), error);
+        disk_index.erase(disk_entries.back());
+        disk_entries.pop_back();
+    }
+}
+
+// Load a disk entry: a complete BMP (checked against bfSize) followed by exactly the expected key
+BMPRenderCache::Buffer BMPRenderCache::readDisk(uint64_t hash, const std::vector<unsigned char> &key) const
+{
+    std::ifstream file(diskPath(hash), std::ios::binary);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 6 || data[0] != 'B' || data[1] != 'M')
+    {
+        return nullptr;
+    }
+
+    const size_t file_size = static_cast<size_t>(data[2]) | static_cast<size_t>(data[3]) << 8 |
+                             static_cast<size_t>(data[4]) << 16 | static_cast<size_t>(data[5]) << 24;
+    if (data.size() != file_size + key.size() || !std::equal(key.begin(), key.end(), data.begin() + file_size))
+    {
+        return nullptr;
+    }
+
+    data.resize(file_size);
+    return std::make_shared<const std::vector<unsigned char>>(std::move(data));
+}
+
+// Write a disk entry under a unique temporary name, then rename it into place
+bool BMPRenderCache::writeDisk(uint64_t hash, const std::vector<unsigned char> &key, const std::vector<unsigned char> &data) const
+{
+    static std::atomic<uint64_t> counter{0};
+
+    const std::string path = diskPath(hash);
+    const std::string temporary = path + ".tmp" +
+                                  std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." +
+                                  std::to_string(counter++);
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (file)
+        {
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            file.write(reinterpret_cast<const char *>(key.data()), static_cast<std::streamsize>(key.size()));
+            file.close();
+        }
+        if (!file)
+        {
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+// Look up an encoded image (memory first, then disk); a hash match with a different key is a miss
+BMPRenderCache::Buffer BMPRenderCache::find(const BMPDrawRecorder &recorder)
+{
+    const uint64_t hash = recorder.hash();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(hash);
+        if (it != index.end() && it->second->key == recorder.key())
+        {
+            entries.splice(entries.begin(), entries, it->second);
+            ++hits;
+            return it->second->buffer;
+        }
+        if (directory.empty())
+        {
+            ++misses;
+            return nullptr;
+        }
+    }
+
+    // The file is read without holding the lock so other workers aren't serialized on disk I/O;
+    // writes are atomic renames, so the read sees either a whole entry or none
+    Buffer buffer = readDisk(hash, recorder.key());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!buffer)
+    {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    touchDiskLocked(hash);
+    return insertLocked(hash, recorder.key(), buffer);
+}
+
+// Store an encoded image (and mirror it to disk if a directory is set)
+BMPRenderCache::Buffer BMPRenderCache::insert(const BMPDrawRecorder &recorder, std::vector<unsigned char> data)
+{
+    Buffer buffer = std::make_shared<const std::vector<unsigned char>>(std::move(data));
+    const bool stored = !directory.empty() && writeDisk(recorder.hash(), recorder.key(), *buffer);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stored)
+    {
+        touchDiskLocked(recorder.hash());
+    }
+    return insertLocked(recorder.hash(), recorder.key(), buffer);
+}
+
+// Return the encoded image for a recording, rasterizing only on a miss
+BMPRenderCache::Buffer BMPRenderCache::render(const BMPDrawRecorder &recorder)
+{
+    Buffer cached = find(recorder);
+    if (cached)
+    {
+        return cached;
+    }
+
+    BMPImageCreator image(recorder.getWidth(), recorder.getHeight());
+    recorder.replay(image);
+    return insert(recorder, image.encodeToBuffer());
+}
+
+// Write the encoded image for a recording to <filename>.bmp
+bool BMPRenderCache::saveFile(const BMPDrawRecorder &recorder, const std::string &filename)
+{
+    Buffer buffer = render(recorder);
+
+    std::ofstream file(filename + ".bmp", std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(buffer->data()), static_cast<std::streamsize>(buffer->size()));
+    return static_cast<bool>(file);
+}
+
+// Statistics
+size_t BMPRenderCache::getHits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+size_t BMPRenderCache::getMisses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
@@ -0,0 +1,166 @@
+#ifndef BMP_RENDER_CACHE_H
+#define BMP_RENDER_CACHE_H
+
+#include "bmp_image_creator.h"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Records draw calls instead of rasterizing them. A version tag, the canvas size and the calls (plus the
+// content hash of the font for text) are also kept as a canonical byte key (compared on cache hits) and a
+// running hash of that key (used to index the cache).
+class BMPDrawRecorder
+{
+public:
+    // Bump whenever rasterization or encoding output changes, so persistent caches stop matching older images
+    static constexpr uint32_t key_version = 1;
+
+    enum class Op : uint8_t
+    {
+        DefaultPixel,
+        Pixel,
+        Rectangle,
+        Line,
+        Circle,
+        Text,
+        LineAA,
+        CircleAA,
+        ThickLine,
+        Polyline,
+        Polygon,
+        GradientRectangle,
+        GradientCircle,
+        GradientPolygon,
+        FloodFill,
+        BoxBlur,
+        GaussianBlur,
+        Shadow
+    };
+
+    struct Command
+    {
+        Op op;
+        std::vector<int32_t> args;
+        std::string text;
+    };
+
+    // Constructor
+    BMPDrawRecorder(int32_t width, int32_t height);
+
+    // Drawing functions (same signatures as BMPImageCreator)
+    void setDefaultPixelRGB(int r, int g, int b);
+    void setPixel(int32_t x, int32_t y, int r, int g, int b);
+    void drawRectangle(int32_t x, int32_t y, int32_t x1, int32_t y1, int r, int g, int b, bool fill);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b);
+    void drawCircle(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill);
+    void drawText(int startX, int startY, const std::string &text, int r, int g, int b, int scale, bool wrap);
+    void drawLineAA(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int r, int g, int b);
+    void drawCircleAA(int32_t centerX, int32_t centerY, int32_t radius, int r, int g, int b, bool fill);
+    void fillPolygon(const std::vector<BMPPoint> &points, int r, int g, int b, BMPFillRule rule = BMPFillRule::NonZero);
+    void fillPolygons(const std::vector<BMPPolygon> &polygons, BMPFillRule rule = BMPFillRule::NonZero);
+    void floodFill(int32_t x, int32_t y, int r, int g, int b);
+    void fillRectangleGradient(int32_t x, int32_t y, int32_t x1, int32_t y1, const BMPGradient &gradient);
+    void fillCircleGradient(int32_t centerX, int32_t centerY, int32_t radius, const BMPGradient &gradient);
+    void fillPolygonGradient(const std::vector<BMPPoint> &points, const BMPGradient &gradient, BMPFillRule rule = BMPFillRule::NonZero);
+    void drawThickLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int thickness, int r, int g, int b,
+                       BMPLineCap cap = BMPLineCap::Butt);
+    void drawPolyline(const std::vector<BMPPoint> &points, int thickness, int r, int g, int b,
+                      BMPLineJoin join = BMPLineJoin::Miter, BMPLineCap cap = BMPLineCap::Butt);
+
+    // Filters (the thread count only affects speed, so it is not recorded)
+    void boxBlur(int radius, unsigned threads = 1);
+    void boxBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int radius, unsigned threads = 1);
+    void gaussianBlur(float sigma, unsigned threads = 1);
+    void gaussianBlur(int32_t x0, int32_t y0, int32_t x1, int32_t y1, float sigma, unsigned threads = 1);
+    void drawShadow(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int blur_radius, int r, int g, int b, int opacity);
+
+    // Recorded state
+    int32_t getWidth() const { return width; }
+    int32_t getHeight() const { return height; }
+    uint64_t hash() const { return hash_value; }
+    const std::vector<unsigned char> &key() const { return key_bytes; }
+    const std::vector<Command> &getCommands() const { return commands; }
+
+    // Run the recorded calls on a canvas
+    void replay(BMPImageCreator &image) const;
+
+    // Start over with a new canvas size
+    void reset(int32_t width, int32_t height);
+
+private:
+    int32_t width;
+    int32_t height;
+    uint64_t hash_value;
+    std::vector<unsigned char> key_bytes;
+    uint64_t font_hash = 0; // content hash of the replay canvas's default font, looked up on the first text call
+    bool font_hash_known = false;
+    std::vector<Command> commands;
+
+    void record(Op op, std::vector<int32_t> args, const std::string &text = "");
+    void appendKey(const void *data, size_t size);
+};
+
+// LRU cache of encoded BMPs for recordings, optionally backed by a directory on disk.
+// Entries are indexed by BMPDrawRecorder::hash() but only hit when the full key matches.
+// Disk entries are <hash>.bmp files holding the image followed by the key (ignored by BMP readers);
+// they are written to a temporary file and renamed, and kept to max_disk_entries least recently used files.
+class BMPRenderCache
+{
+public:
+    using Buffer = std::shared_ptr<const std::vector<unsigned char>>;
+
+    // Constructor (empty directory = memory only; existing files in the directory are picked up)
+    explicit BMPRenderCache(size_t max_entries = 256, const std::string &directory = "", size_t max_disk_entries = 4096);
+
+    // Lookup / store encoded images
+    Buffer find(const BMPDrawRecorder &recorder);
+    Buffer insert(const BMPDrawRecorder &recorder, std::vector<unsigned char> data);
+
+    // Return the encoded image for a recording, rasterizing only on a miss
+    Buffer render(const BMPDrawRecorder &recorder);
+
+    // Write the encoded image for a recording to <filename>.bmp
+    bool saveFile(const BMPDrawRecorder &recorder, const std::string &filename);
+
+    // Statistics
+    size_t getHits() const;
+    size_t getMisses() const;
+
+private:
+    struct Entry
+    {
+        uint64_t hash;
+        std::vector<unsigned char> key;
+        Buffer buffer;
+    };
+
+    size_t max_entries;
+    std::string directory;
+    size_t max_disk_entries;
+
+    // Memory LRU, most recent first
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+
+    // Disk LRU (hashes of the files in directory), most recent first
+    std::list<uint64_t> disk_entries;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> disk_index;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    mutable std::mutex mutex;
+
+    std::string diskPath(uint64_t hash) const;
+    Buffer insertLocked(uint64_t hash, const std::vector<unsigned char> &key, Buffer buffer);
+    Buffer readDisk(uint64_t hash, const std::vector<unsigned char> &key) const;
+    bool writeDisk(uint64_t hash, const std::vector<unsigned char> &key, const std::vector<unsigned char> &data) const;
+    void touchDiskLocked(uint64_t hash);
+};
+
+#endif // BMP_RENDER_CACHE_H
@@ -0,0 +1,374 @@
+#include "bmp_scene.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    // Splits one line into tokens without copying it
+    class LineReader
+    {
+    public:
+        explicit LineReader(std::string_view line) : rest(line) {}
+
+        // Next whitespace-separated word (empty at end of line or at a comment)
+        std::string_view word()
+        {
+            skipSpaces();
+            if (rest.empty() || rest.front() == '#')
+                return {};
+            size_t end = rest.find_first_of(" \t\r");
+            std::string_view token = rest.substr(0, end);
+            rest.remove_prefix(end == std::string_view::npos ? rest.size() : end);
+            return token;
+        }
+
+        bool integer(int32_t &value)
+        {
+            std::string_view token = word();
+            if (token.empty())
+                return false;
+            auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+            return result.ec == std::errc() && result.ptr == token.data() + token.size();
+        }
+
+        // Decimal number such as 2.5 (finite values only)
+        bool number(float &value)
+        {
+            const std::string token(word());
+            if (token.empty())
+                return false;
+            char *end = nullptr;
+            value = std::strtof(token.c_str(), &end);
+            return end == token.c_str() + token.size() && std::isfinite(value);
+        }
+
+        bool integers(int32_t *values, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                if (!integer(values[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        // Optional trailing keyword such as "fill" or "wrap"
+        bool flag(std::string_view keyword)
+        {
+            skipSpaces();
+            if (rest.substr(0, keyword.size()) != keyword)
+                return false;
+            std::string_view after = rest.substr(keyword.size());
+            if (!after.empty() && after.front() != ' ' && after.front() != '\t' && after.front() != '\r' && after.front() != '#')
+                return false;
+            rest = after;
+            return true;
+        }
+
+        // Double-quoted string with \n, \" and \\ escapes
+        bool quoted(std::string &out)
+        {
+            skipSpaces();
+            if (rest.empty() || rest.front() != '"')
+                return false;
+            out.clear();
+            for (size_t i = 1; i < rest.size(); ++i)
+            {
+                char c = rest[i];
+                if (c == '"')
+                {
+                    rest.remove_prefix(i + 1);
+                    return true;
+                }
+                if (c == '\\' && i + 1 < rest.size())
+                {
+                    c = rest[++i];
+                    if (c == 'n')
+                        c = '\n';
+                }
+                out.push_back(c);
+            }
+            return false;
+        }
+
+        bool atEnd()
+        {
+            skipSpaces();
+            return rest.empty() || rest.front() == '#';
+        }
+
+    private:
+        std::string_view rest;
+
+        void skipSpaces()
+        {
+            while (!rest.empty() && (rest.front() == ' ' || rest.front() == '\t' || rest.front() == '\r'))
+                rest.remove_prefix(1);
+        }
+    };
+
+    // Optional cap / join keywords (default butt / miter)
+    BMPLineCap readCap(LineReader &line)
+    {
+        if (line.flag("round"))
+            return BMPLineCap::Round;
+        if (line.flag("square"))
+            return BMPLineCap::Square;
+        line.flag("butt");
+        return BMPLineCap::Butt;
+    }
+
+    BMPLineJoin readJoin(LineReader &line)
+    {
+        if (line.flag("round"))
+            return BMPLineJoin::Round;
+        if (line.flag("bevel"))
+            return BMPLineJoin::Bevel;
+        line.flag("miter");
+        return BMPLineJoin::Miter;
+    }
+
+    // Optional x,y pairs up to the end of the line
+    bool readPoints(LineReader &line, std::vector<BMPPoint> &points)
+    {
+        points.clear();
+        int32_t xy[2];
+        while (!line.atEnd())
+        {
+            if (!line.integers(xy, 2))
+                return false;
+            points.push_back({xy[0], xy[1]});
+        }
+        return true;
+    }
+
+    // linear/radial gradient followed by percent r g b stops up to the end of the line
+    bool readGradient(LineReader &line, BMPGradient &gradient)
+    {
+        int32_t v[4];
+        if (line.flag("linear"))
+        {
+            if (!line.integers(v, 4))
+                return false;
+            gradient = BMPGradient::linear(v[0], v[1], v[2], v[3], {});
+        }
+        else if (line.flag("radial"))
+        {
+            if (!line.integers(v, 3))
+                return false;
+            gradient = BMPGradient::radial(v[0], v[1], v[2], {});
+        }
+        else
+        {
+            return false;
+        }
+
+        while (!line.atEnd())
+        {
+            if (!line.integers(v, 4))
+                return false;
+            gradient.stops.push_back({v[0] / 100.0f, v[1], v[2], v[3]});
+        }
+        return !gradient.stops.empty();
+    }
+
+    bool fail(std::string *error, size_t line_number, const std::string &message)
+    {
+        if (error)
+            *error = "line " + std::to_string(line_number) + ": " + message;
+        return false;
+    }
+}
+
+// Parse a scene from memory
+bool parseScene(std::string_view source, BMPDrawRecorder &recorder, std::string *error)
+{
+    bool have_size = false;
+    size_t line_number = 0;
+    std::string text;
+    std::vector<BMPPoint> points;
+    BMPGradient gradient;
+
+    while (!source.empty())
+    {
+        ++line_number;
+        size_t end = source.find('\n');
+        LineReader line(source.substr(0, end));
+        source.remove_prefix(end == std::string_view::npos ? source.size() : end + 1);
+
+        std::string_view command = line.word();
+        if (command.empty())
+            continue;
+
+        int32_t a[9];
+        bool ok;
+        if (command == "size")
+        {
+            ok = !have_size && line.integers(a, 2);
+            if (ok && a[0] > 0 && a[1] > 0 && !BMPImageCreator::validSize(a[0], a[1]))
+                return fail(error, line_number, "size too large for a BMP file");
+            if (ok)
+            {
+                recorder.reset(a[0], a[1]);
+                have_size = true;
+            }
+        }
+        else if (!have_size)
+        {
+            return fail(error, line_number, "'size' must be the first command");
+        }
+        else if (command == "background")
+        {
+            ok = line.integers(a, 3);
+            if (ok)
+                recorder.setDefaultPixelRGB(a[0], a[1], a[2]);
+        }
+        else if (command == "pixel")
+        {
+            ok = line.integers(a, 5);
+            if (ok)
+                recorder.setPixel(a[0], a[1], a[2], a[3], a[4]);
+        }
+        else if (command == "rect")
+        {
+            ok = line.integers(a, 7);
+            if (ok)
+                recorder.drawRectangle(a[0], a[1], a[2], a[3], a[4], a[5], a[6], line.flag("fill"));
+        }
+        else if (command == "line")
+        {
+            ok = line.integers(a, 7);
+            if (ok)
+                recorder.drawLine(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+        }
+        else if (command == "circle")
+        {
+            ok = line.integers(a, 6);
+            if (ok)
+                recorder.drawCircle(a[0], a[1], a[2], a[3], a[4], a[5], line.flag("fill"));
+        }
+        else if (command == "line_aa")
+        {
+            ok = line.integers(a, 7);
+            if (ok)
+                recorder.drawLineAA(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+        }
+        else if (command == "circle_aa")
+        {
+            ok = line.integers(a, 6);
+            if (ok)
+                recorder.drawCircleAA(a[0], a[1], a[2], a[3], a[4], a[5], line.flag("fill"));
+        }
+        else if (command == "polygon")
+        {
+            ok = line.integers(a, 3);
+            BMPFillRule rule = line.flag("evenodd") ? BMPFillRule::EvenOdd : BMPFillRule::NonZero;
+            line.flag("nonzero");
+            ok = ok && readPoints(line, points);
+            if (ok)
+                recorder.fillPolygon(points, a[0], a[1], a[2], rule);
+        }
+        else if (command == "flood")
+        {
+            ok = line.integers(a, 5);
+            if (ok)
+                recorder.floodFill(a[0], a[1], a[2], a[3], a[4]);
+        }
+        else if (command == "gradient_rect")
+        {
+            ok = line.integers(a, 4) && readGradient(line, gradient);
+            if (ok)
+                recorder.fillRectangleGradient(a[0], a[1], a[2], a[3], gradient);
+        }
+        else if (command == "gradient_circle")
+        {
+            ok = line.integers(a, 3) && readGradient(line, gradient);
+            if (ok)
+                recorder.fillCircleGradient(a[0], a[1], a[2], gradient);
+        }
+        else if (command == "thick_line")
+        {
+            ok = line.integers(a, 8);
+            if (ok)
+                recorder.drawThickLine(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], readCap(line));
+        }
+        else if (command == "polyline")
+        {
+            ok = line.integers(a, 4);
+            BMPLineJoin join = readJoin(line);
+            BMPLineCap cap = readCap(line);
+            ok = ok && readPoints(line, points);
+            if (ok)
+                recorder.drawPolyline(points, a[0], a[1], a[2], a[3], join, cap);
+        }
+        else if (command == "blur")
+        {
+            ok = line.integer(a[0]);
+            if (ok && line.atEnd())
+                recorder.boxBlur(a[0]);
+            else if (ok && (ok = line.integers(a + 1, 4)))
+                recorder.boxBlur(a[1], a[2], a[3], a[4], a[0]);
+        }
+        else if (command == "gaussian_blur")
+        {
+            float sigma = 0.0f;
+            ok = line.number(sigma);
+            if (ok && line.atEnd())
+                recorder.gaussianBlur(sigma);
+            else if (ok && (ok = line.integers(a, 4)))
+                recorder.gaussianBlur(a[0], a[1], a[2], a[3], sigma);
+        }
+        else if (command == "shadow")
+        {
+            ok = line.integers(a, 9);
+            if (ok)
+                recorder.drawShadow(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8]);
+        }
+        else if (command == "text")
+        {
+            ok = line.integers(a, 6);
+            bool wrap = ok && line.flag("wrap");
+            ok = ok && line.quoted(text);
+            if (ok)
+                recorder.drawText(a[0], a[1], text, a[2], a[3], a[4], a[5], wrap);
+        }
+        else
+        {
+            return fail(error, line_number, "unknown command '" + std::string(command) + "'");
+        }
+
+        if (!ok || !line.atEnd())
+            return fail(error, line_number, "bad arguments for '" + std::string(command) + "'");
+    }
+
+    if (!have_size)
+        return fail(error, line_number, "missing 'size'");
+    return true;
+}
+
+// Read and parse a scene file
+bool loadSceneFile(const std::string &filename, BMPDrawRecorder &recorder, std::string *error)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        if (error)
+            *error = "can't open " + filename;
+        return false;
+    }
+
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!parseScene(source, recorder, error))
+    {
+        if (error)
+            *error = filename + ": " + *error;
+        return false;
+    }
+    return true;
+}
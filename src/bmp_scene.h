@@ -0,0 +1,40 @@
+#ifndef BMP_SCENE_H
+#define BMP_SCENE_H
+
+#include "bmp_render_cache.h"
+
+#include <string>
+#include <string_view>
+
+// Text scene format, one command per line ('#' starts a comment):
+//
+//   size       <width> <height>                                 (must come first and fit a BMP file, see validSize)
+//   background <r> <g> <b>
+//   pixel      <x> <y> <r> <g> <b>
+//   rect       <x0> <y0> <x1> <y1> <r> <g> <b> [fill]
+//   line       <x0> <y0> <x1> <y1> <r> <g> <b>
+//   circle     <cx> <cy> <radius> <r> <g> <b> [fill]
+//   line_aa    <x0> <y0> <x1> <y1> <r> <g> <b>
+//   circle_aa  <cx> <cy> <radius> <r> <g> <b> [fill]
+//   polygon    <r> <g> <b> [nonzero|evenodd] <x0> <y0> <x1> <y1> <x2> <y2> ...
+//   flood      <x> <y> <r> <g> <b>
+//   gradient_rect   <x0> <y0> <x1> <y1> <gradient>
+//   gradient_circle <cx> <cy> <radius> <gradient>
+//     where <gradient> is  linear <gx0> <gy0> <gx1> <gy1> <stops>  or  radial <gcx> <gcy> <gradius> <stops>
+//     and <stops> is one or more  <position 0..100> <r> <g> <b>
+//   thick_line <x0> <y0> <x1> <y1> <thickness> <r> <g> <b> [butt|round|square]
+//   polyline   <thickness> <r> <g> <b> [miter|round|bevel] [butt|round|square] <x0> <y0> <x1> <y1> ...
+//   text       <x> <y> <r> <g> <b> <scale> [wrap] "<text>"    (\n, \" and \\ escapes)
+//   blur          <radius> [<x0> <y0> <x1> <y1>]                 (box blur of the canvas or a rectangle)
+//   gaussian_blur <sigma> [<x0> <y0> <x1> <y1>]                  (sigma may be fractional, e.g. 2.5)
+//   shadow        <x0> <y0> <x1> <y1> <blur_radius> <r> <g> <b> <opacity>
+//
+// Scenes are parsed straight into a BMPDrawRecorder, so they can be cached or batch rendered.
+
+// Parse a scene from memory; on failure returns false and describes the problem in error
+bool parseScene(std::string_view source, BMPDrawRecorder &recorder, std::string *error = nullptr);
+
+// Read and parse a scene file
+bool loadSceneFile(const std::string &filename, BMPDrawRecorder &recorder, std::string *error = nullptr);
+
+#endif // BMP_SCENE_H
@@ -0,0 +1,153 @@
+// Benchmark: analytic anti-aliasing (drawLineAA / drawCircleAA) against rendering at 4x and resolve(4).
+//
+// Usage: bmp_aa_bench [-n shapes] [-s width height] [-r repeats]
+// Draws the same random lines and filled circles both ways (fixed seed) and prints the best time of
+// each method, shapes per second and the mean per-channel difference between the two results.
+
+#include "../src/bmp_image_creator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Shape
+{
+    int32_t x0;
+    int32_t y0;
+    int32_t x1; // circle: radius in x1
+    int32_t y1;
+    int r;
+    int g;
+    int b;
+};
+
+// Best wall time of repeats runs, in milliseconds
+template <typename Function>
+static double bestMilliseconds(int repeats, Function function)
+{
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+// Mean absolute difference per channel byte of two same-sized canvases
+static double meanDifference(const BMPImageCreator &a, const BMPImageCreator &b)
+{
+    std::vector<unsigned char> row_a(static_cast<size_t>(a.getWidth()) * 3);
+    std::vector<unsigned char> row_b(row_a.size());
+    uint64_t total = 0;
+    for (int32_t y = 0; y < a.getHeight(); ++y)
+    {
+        a.readRowRGB(y, row_a.data());
+        b.readRowRGB(y, row_b.data());
+        for (size_t i = 0; i < row_a.size(); ++i)
+            total += static_cast<uint64_t>(std::abs(row_a[i] - row_b[i]));
+    }
+    return static_cast<double>(total) / (static_cast<double>(row_a.size()) * a.getHeight());
+}
+
+// Print one comparison line
+static void report(const char *name, size_t count, double analytic_ms, double supersampled_ms, double difference)
+{
+    std::printf("%-8s analytic %9.2f ms (%10.0f shapes/s)   4x + resolve %9.2f ms (%10.0f shapes/s)   speedup %5.2fx   mean diff %.2f\n",
+                name, analytic_ms, count / (analytic_ms / 1000.0), supersampled_ms, count / (supersampled_ms / 1000.0),
+                supersampled_ms / analytic_ms, difference);
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = 2000;
+    int32_t width = 1024;
+    int32_t height = 768;
+    int repeats = 3;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+        {
+            count = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-s" && i + 2 < argc)
+        {
+            width = static_cast<int32_t>(std::strtol(argv[++i], nullptr, 10));
+            height = static_cast<int32_t>(std::strtol(argv[++i], nullptr, 10));
+        }
+        else if (arg == "-r" && i + 1 < argc)
+        {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [-n shapes] [-s width height] [-r repeats]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (count == 0 || !BMPImageCreator::validSize(width, height) || !BMPImageCreator::validSize(width * 4, height * 4))
+    {
+        std::fprintf(stderr, "Invalid shape count or canvas size\n");
+        return 1;
+    }
+
+    std::mt19937 random(12345);
+    std::uniform_int_distribution<int32_t> random_x(0, width - 1);
+    std::uniform_int_distribution<int32_t> random_y(0, height - 1);
+    std::uniform_int_distribution<int32_t> random_radius(2, std::max(3, std::min(width, height) / 8));
+    std::uniform_int_distribution<int> random_channel(0, 255);
+
+    std::vector<Shape> lines(count);
+    std::vector<Shape> circles(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        lines[i] = {random_x(random), random_y(random), random_x(random), random_y(random),
+                    random_channel(random), random_channel(random), random_channel(random)};
+        circles[i] = {random_x(random), random_y(random), random_radius(random), 0,
+                      random_channel(random), random_channel(random), random_channel(random)};
+    }
+
+    std::printf("%zu shapes on %dx%d, best of %d\n", count, width, height, repeats);
+
+    // Lines: 1 px AA lines against 4 px thick lines at 4x, so both cover the same area once resolved
+    BMPImageCreator analytic(width, height);
+    BMPImageCreator large(width * 4, height * 4);
+    BMPImageCreator resolved(width, height);
+
+    const double line_analytic = bestMilliseconds(repeats, [&]
+                                                  {
+        analytic.setDefaultPixelRGB(255, 255, 255);
+        for (const Shape &s : lines)
+            analytic.drawLineAA(s.x0, s.y0, s.x1, s.y1, s.r, s.g, s.b); });
+    const double line_supersampled = bestMilliseconds(repeats, [&]
+                                                      {
+        large.setDefaultPixelRGB(255, 255, 255);
+        for (const Shape &s : lines)
+            large.drawThickLine(s.x0 * 4 + 2, s.y0 * 4 + 2, s.x1 * 4 + 2, s.y1 * 4 + 2, 4, s.r, s.g, s.b);
+        resolved = large.resolve(4); });
+    report("lines", count, line_analytic, line_supersampled, meanDifference(analytic, resolved));
+
+    // Filled circles
+    const double circle_analytic = bestMilliseconds(repeats, [&]
+                                                    {
+        analytic.setDefaultPixelRGB(255, 255, 255);
+        for (const Shape &s : circles)
+            analytic.drawCircleAA(s.x0, s.y0, s.x1, s.r, s.g, s.b, true); });
+    const double circle_supersampled = bestMilliseconds(repeats, [&]
+                                                        {
+        large.setDefaultPixelRGB(255, 255, 255);
+        for (const Shape &s : circles)
+            large.drawCircle(s.x0 * 4 + 2, s.y0 * 4 + 2, s.x1 * 4, s.r, s.g, s.b, true);
+        resolved = large.resolve(4); });
+    report("circles", count, circle_analytic, circle_supersampled, meanDifference(analytic, resolved));
+
+    return 0;
+}
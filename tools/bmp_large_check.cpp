@@ -0,0 +1,298 @@
+// Large-image check: renders canvases of 20000x20000 and beyond, encodes each straight into a sparse,
+// memory-mapped output file, maps the file back and verifies every header field and pixel against the
+// drawn pattern. Prints the throughput of each stage to stdout.
+//
+// Usage: bmp_large_check [-d dir] [-k] [-f bgr|bgra|gray] [WIDTHxHEIGHT...]
+// -f applies to the sizes after it, -k keeps the written files. With no sizes, checks 20000x20000 BGR24
+// and 40000x40000 Gray8 in /tmp. Also checks that sizes past the 4 GiB BMP limit are reported as errors.
+// POSIX only (ftruncate + mmap); needs about twice the largest file in free memory and disk space.
+
+#include "../src/bmp_image_creator.h"
+#include "../src/bmp_batch_renderer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct Case
+{
+    char format; // 'b' BGR24, 'a' BGRA32, 'g' Gray8
+    int32_t width;
+    int32_t height;
+};
+
+// Pattern colors, before conversion to the canvas format
+static const int background[3] = {17, 34, 51};
+static const int block[3] = {200, 100, 50};
+static const int row_line[3] = {10, 220, 30};
+static const int column_line[3] = {240, 240, 0};
+static const int corners[4][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 0, 255}};
+
+// Wall time since start, in seconds
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Little-endian header fields
+static uint32_t readU32(const unsigned char *p)
+{
+    return static_cast<uint32_t>(p[0]) | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+static int32_t readI32(const unsigned char *p)
+{
+    return static_cast<int32_t>(readU32(p));
+}
+
+// Print one stage: time, and throughput in MB/s (bytes) and megapixels/s
+static void report(const char *stage, double seconds, uint64_t bytes, uint64_t pixels)
+{
+    std::printf("  %-10s %8.3f s  %9.1f MB/s  %9.1f Mpx/s\n", stage, seconds, bytes / seconds / 1e6, pixels / seconds / 1e6);
+    std::fflush(stdout);
+}
+
+// Color the pattern has at (x, y), as stored by the canvas format
+template <typename Format>
+static std::array<unsigned char, 3> expectedColor(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    const int *c = background;
+    if (x >= width / 4 && x < width / 4 * 3 && y >= height / 4 && y < height / 4 * 3)
+        c = block;
+    if (y == height / 8)
+        c = row_line;
+    if (x == width / 8)
+        c = column_line;
+    if ((x == 0 || x == width - 1) && (y == 0 || y == height - 1))
+        c = corners[(y == 0 ? 0 : 2) + (x == 0 ? 0 : 1)];
+
+    const typename Format::Pixel pixel = Format::pack(static_cast<unsigned char>(c[0]), static_cast<unsigned char>(c[1]),
+                                                      static_cast<unsigned char>(c[2]));
+    return Format::unpack(pixel.data());
+}
+
+// Decode the mapped file independently of the canvas and compare it with the pattern
+template <typename Format>
+static bool verify(const unsigned char *file, uint64_t file_size, int32_t width, int32_t height, std::string &error)
+{
+    const uint64_t row_size = (static_cast<uint64_t>(width) * Format::bits_per_pixel / 8 + 3) / 4 * 4;
+    const uint32_t offset = readU32(file + 10);
+    if (file[0] != 'B' || file[1] != 'M' || readU32(file + 2) != file_size || readI32(file + 18) != width ||
+        readI32(file + 22) != height || (file[28] | file[29] << 8) != Format::bits_per_pixel ||
+        readU32(file + 34) != row_size * height || offset + row_size * height != file_size)
+    {
+        error = "header fields do not match the canvas";
+        return false;
+    }
+
+    // Gray palette entries map indices back to BGR
+    const unsigned char *palette = file + 14 + readU32(file + 14);
+    for (int32_t y = 0; y < height; ++y)
+    {
+        const unsigned char *row = file + offset + static_cast<uint64_t>(height - 1 - y) * row_size;
+        for (int32_t x = 0; x < width; ++x)
+        {
+            const unsigned char *p = Format::palette_size > 0 ? palette + 4 * row[x] : row + static_cast<size_t>(x) * Format::bytes_per_pixel;
+            const std::array<unsigned char, 3> expected = expectedColor<Format>(x, y, width, height);
+            if (p[2] != expected[0] || p[1] != expected[1] || p[0] != expected[2])
+            {
+                error = "pixel (" + std::to_string(x) + ", " + std::to_string(y) + ") differs";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Render, encode into a mapped sparse file, save through saveFile and verify one size
+template <typename Format>
+static bool runCase(const char *format_name, int32_t width, int32_t height, const std::string &dir, bool keep)
+{
+    std::printf("%dx%d %s\n", width, height, format_name);
+    if (!BasicBMPImageCreator<Format>::validSize(width, height))
+    {
+        std::printf("  skipped: not a valid BMP size (see the limit check)\n");
+        return true;
+    }
+
+    const uint64_t pixel_count = static_cast<uint64_t>(width) * height;
+    const std::string base = dir + "/bmp_large_check_" + std::to_string(width) + "x" + std::to_string(height) + "_" + format_name;
+
+    auto start = std::chrono::steady_clock::now();
+    BasicBMPImageCreator<Format> canvas(width, height);
+    const uint64_t file_size = canvas.encodedSize();
+    report("allocate", secondsSince(start), file_size, pixel_count);
+
+    start = std::chrono::steady_clock::now();
+    canvas.setDefaultPixelRGB(background[0], background[1], background[2]);
+    canvas.drawRectangle(width / 4, height / 4, width / 4 * 3 - 1, height / 4 * 3 - 1, block[0], block[1], block[2], true);
+    canvas.drawLine(0, height / 8, width - 1, height / 8, row_line[0], row_line[1], row_line[2]);
+    canvas.drawLine(width / 8, 0, width / 8, height - 1, column_line[0], column_line[1], column_line[2]);
+    canvas.setPixel(0, 0, corners[0][0], corners[0][1], corners[0][2]);
+    canvas.setPixel(width - 1, 0, corners[1][0], corners[1][1], corners[1][2]);
+    canvas.setPixel(0, height - 1, corners[2][0], corners[2][1], corners[2][2]);
+    canvas.setPixel(width - 1, height - 1, corners[3][0], corners[3][1], corners[3][2]);
+    report("draw", secondsSince(start), file_size, pixel_count);
+
+    // The file is sized with ftruncate, so it stays sparse until the encoder touches each page
+    const std::string mapped_name = base + "_mapped.bmp";
+    const int fd = open(mapped_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(file_size)) != 0)
+    {
+        std::printf("  FAILED: cannot create %s: %s\n", mapped_name.c_str(), std::strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::printf("  FAILED: cannot map %s: %s\n", mapped_name.c_str(), std::strerror(errno));
+        unlink(mapped_name.c_str());
+        return false;
+    }
+    unsigned char *file = static_cast<unsigned char *>(mapping);
+
+    start = std::chrono::steady_clock::now();
+    const size_t written = canvas.encodeToBuffer(file, file_size);
+    report("encode", secondsSince(start), file_size, pixel_count);
+
+    start = std::chrono::steady_clock::now();
+    msync(file, file_size, MS_SYNC);
+    report("msync", secondsSince(start), file_size, pixel_count);
+
+    start = std::chrono::steady_clock::now();
+    const bool saved_ok = canvas.saveFile(base + "_saved");
+    report("saveFile", secondsSince(start), file_size, pixel_count);
+
+    struct stat saved;
+    bool ok = written == file_size && saved_ok && stat((base + "_saved.bmp").c_str(), &saved) == 0 &&
+              static_cast<uint64_t>(saved.st_size) == file_size;
+    std::string error = ok ? "" : "encoded or saved size does not match encodedSize()";
+
+    // Free the canvas before reading back so both copies never need to be resident
+    canvas = BasicBMPImageCreator<Format>(1, 1);
+    start = std::chrono::steady_clock::now();
+    ok = ok && verify<Format>(file, file_size, width, height, error);
+    report("verify", secondsSince(start), file_size, pixel_count);
+
+    munmap(mapping, file_size);
+    if (!keep)
+    {
+        unlink(mapped_name.c_str());
+        unlink((base + "_saved.bmp").c_str());
+    }
+
+    std::printf("  %s%s\n", ok ? "ok" : "FAILED: ", error.c_str());
+    return ok;
+}
+
+// Sizes whose file would pass 4 GiB must be reported, not turned into a tiny canvas
+static bool checkLimits()
+{
+    std::printf("size limit\n");
+    bool ok = true;
+
+    try
+    {
+        BMPImageCreator too_large(40000, 40000);
+        std::printf("  FAILED: 40000x40000 BGR24 was accepted as %dx%d\n", too_large.getWidth(), too_large.getHeight());
+        ok = false;
+    }
+    catch (const std::length_error &e)
+    {
+        std::printf("  constructor: %s\n", e.what());
+    }
+
+    BMPImageCreator canvas(8, 8);
+    try
+    {
+        canvas.reset(70000, 70000);
+        std::printf("  FAILED: reset accepted 70000x70000 BGR24\n");
+        ok = false;
+    }
+    catch (const std::length_error &)
+    {
+        ok = ok && canvas.getWidth() == 8 && canvas.getHeight() == 8;
+        std::printf("  reset: threw, canvas left at %dx%d\n", canvas.getWidth(), canvas.getHeight());
+    }
+
+    BMPRenderJob job;
+    job.width = 40000;
+    job.height = 40000;
+    BMPBatchRenderer renderer(1);
+    const BMPBatchStats stats = renderer.run({job});
+    ok = ok && stats.failed_jobs == 1 && stats.job_failed[0] == 1;
+    std::printf("  batch: %zu of 1 jobs flagged as failed\n", stats.failed_jobs);
+
+    std::printf("  %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = "/tmp";
+    bool keep = false;
+    char format = 'b';
+    std::vector<Case> cases;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        int32_t width = 0;
+        int32_t height = 0;
+        char tail = 0;
+        if (arg == "-d" && i + 1 < argc)
+        {
+            dir = argv[++i];
+        }
+        else if (arg == "-k")
+        {
+            keep = true;
+        }
+        else if (arg == "-f" && i + 1 < argc && (std::string(argv[i + 1]) == "bgr" || std::string(argv[i + 1]) == "bgra" ||
+                                                 std::string(argv[i + 1]) == "gray"))
+        {
+            const std::string name = argv[++i];
+            format = name == "bgr" ? 'b' : name == "bgra" ? 'a' : 'g';
+        }
+        else if (std::sscanf(arg.c_str(), "%dx%d%c", &width, &height, &tail) == 2 && width > 0 && height > 0)
+        {
+            cases.push_back({format, width, height});
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [-d dir] [-k] [-f bgr|bgra|gray] [WIDTHxHEIGHT...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (cases.empty())
+    {
+        cases.push_back({'b', 20000, 20000});
+        cases.push_back({'g', 40000, 40000});
+    }
+
+    bool ok = checkLimits();
+    for (const Case &c : cases)
+    {
+        if (c.format == 'b')
+            ok = runCase<BGR24>("BGR24", c.width, c.height, dir, keep) && ok;
+        else if (c.format == 'a')
+            ok = runCase<BGRA32>("BGRA32", c.width, c.height, dir, keep) && ok;
+        else
+            ok = runCase<Gray8>("Gray8", c.width, c.height, dir, keep) && ok;
+    }
+
+    std::printf("%s\n", ok ? "all checks passed" : "some checks FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+// Round-trip check: encodes test canvases with writeQOI and decodes them with an independent decoder written
+// from the QOI specification (https://qoiformat.org/qoi-specification.pdf), then compares every pixel.
+//
+// Usage: bmp_qoi_check
+// Prints one line per case and exits with status 1 if any decoded image differs from its canvas.
+
+#include "../src/bmp_image_creator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Reference decoder: RGB pixels, top-down rows. Returns false on a malformed stream or, since the
+// encoder writes 3-channel files, on any pixel that does not decode as opaque.
+static bool decodeQOI(const std::vector<unsigned char> &data, uint32_t &width, uint32_t &height,
+                      std::vector<unsigned char> &pixels)
+{
+    if (data.size() < 14 + 8 || data[0] != 'q' || data[1] != 'o' || data[2] != 'i' || data[3] != 'f')
+        return false;
+    width = static_cast<uint32_t>(data[4]) << 24 | data[5] << 16 | data[6] << 8 | data[7];
+    height = static_cast<uint32_t>(data[8]) << 24 | data[9] << 16 | data[10] << 8 | data[11];
+    const uint64_t count = static_cast<uint64_t>(width) * height;
+    pixels.assign(count * 3, 0);
+
+    std::array<std::array<unsigned char, 4>, 64> index{};
+    std::array<unsigned char, 4> px = {0, 0, 0, 255};
+    const size_t end = data.size() - 8;
+    size_t p = 14;
+    int run = 0;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (run > 0)
+        {
+            --run;
+        }
+        else
+        {
+            if (p >= end)
+                return false;
+            const unsigned char b1 = data[p++];
+            if (b1 == 0xfe)
+            {
+                px[0] = data[p];
+                px[1] = data[p + 1];
+                px[2] = data[p + 2];
+                p += 3;
+            }
+            else if (b1 == 0xff)
+            {
+                px = {data[p], data[p + 1], data[p + 2], data[p + 3]};
+                p += 4;
+            }
+            else if ((b1 & 0xc0) == 0x00)
+            {
+                px = index[b1];
+            }
+            else if ((b1 & 0xc0) == 0x40)
+            {
+                px[0] += ((b1 >> 4) & 0x03) - 2;
+                px[1] += ((b1 >> 2) & 0x03) - 2;
+                px[2] += (b1 & 0x03) - 2;
+            }
+            else if ((b1 & 0xc0) == 0x80)
+            {
+                const unsigned char b2 = data[p++];
+                const int dg = (b1 & 0x3f) - 32;
+                px[0] += dg - 8 + ((b2 >> 4) & 0x0f);
+                px[1] += dg;
+                px[2] += dg - 8 + (b2 & 0x0f);
+            }
+            else
+            {
+                run = b1 & 0x3f;
+            }
+            index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64] = px;
+        }
+        if (px[3] != 255)
+            return false;
+        pixels[i * 3] = px[0];
+        pixels[i * 3 + 1] = px[1];
+        pixels[i * 3 + 2] = px[2];
+    }
+
+    const unsigned char end_marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    return p == end && std::equal(end_marker, end_marker + 8, data.begin() + end);
+}
+
+// Encode a canvas, decode it again and compare against readRowRGB
+template <typename Canvas>
+static bool check(const char *name, const Canvas &canvas, size_t chunk_size = 65536)
+{
+    std::vector<unsigned char> data;
+    canvas.writeQOI([&data](const unsigned char *chunk, size_t size)
+                    {
+        data.insert(data.end(), chunk, chunk + size);
+        return true; },
+                    chunk_size);
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<unsigned char> pixels;
+    bool ok = decodeQOI(data, width, height, pixels) &&
+              width == static_cast<uint32_t>(canvas.getWidth()) && height == static_cast<uint32_t>(canvas.getHeight());
+
+    std::vector<unsigned char> row(static_cast<size_t>(canvas.getWidth()) * 3);
+    for (int32_t y = 0; ok && y < canvas.getHeight(); ++y)
+    {
+        canvas.readRowRGB(y, row.data());
+        ok = std::equal(row.begin(), row.end(), pixels.begin() + static_cast<size_t>(y) * row.size());
+    }
+
+    std::printf("%-24s %8zu bytes  %s\n", name, data.size(), ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    std::mt19937 random(12345);
+    std::uniform_int_distribution<int> channel(0, 255);
+
+    // Opaque black right after another color hashes to the slot an all-zero index would claim
+    BMPImageCreator black(4, 1);
+    black.setDefaultPixelRGB(0, 0, 0);
+    black.setPixel(0, 0, 255, 255, 255);
+    ok &= check("black after white", black);
+
+    BMPImageCreator all_black(100, 7);
+    all_black.setDefaultPixelRGB(0, 0, 0);
+    ok &= check("all black (long runs)", all_black);
+
+    BMPImageCreator noise(97, 53);
+    for (int32_t y = 0; y < noise.getHeight(); ++y)
+        for (int32_t x = 0; x < noise.getWidth(); ++x)
+            noise.setPixel(x, y, channel(random), channel(random), channel(random));
+    ok &= check("noise", noise);
+    ok &= check("noise, 64-byte chunks", noise, 64);
+
+    // Small steps exercise QOI_OP_DIFF / QOI_OP_LUMA, a short palette exercises QOI_OP_INDEX
+    BMPImageCreator gradient(256, 64);
+    for (int32_t y = 0; y < gradient.getHeight(); ++y)
+        for (int32_t x = 0; x < gradient.getWidth(); ++x)
+            gradient.setPixel(x, y, x, (x + y * 3) & 255, (x * 2 - y) & 255);
+    ok &= check("gradient", gradient);
+
+    BMPImageCreator palette(120, 40);
+    const int colors[5][3] = {{0, 0, 0}, {255, 255, 255}, {255, 0, 0}, {0, 0, 255}, {10, 200, 30}};
+    std::uniform_int_distribution<int> pick(0, 4);
+    for (int32_t y = 0; y < palette.getHeight(); ++y)
+        for (int32_t x = 0; x < palette.getWidth(); ++x)
+        {
+            const int *c = colors[pick(random)];
+            palette.setPixel(x, y, c[0], c[1], c[2]);
+        }
+    ok &= check("palette", palette);
+
+    BMPImageCreatorBGRA bgra(64, 64);
+    bgra.drawCircle(32, 32, 20, 0, 0, 0, true);
+    bgra.drawLineAA(0, 0, 63, 40, 200, 10, 90);
+    ok &= check("BGRA32 canvas", bgra);
+
+    BMPImageCreatorGray gray(64, 64);
+    gray.setDefaultPixelRGB(0, 0, 0);
+    gray.drawRectangle(8, 8, 40, 50, 255, 255, 255, true);
+    gray.drawLineAA(0, 63, 63, 0, 128, 128, 128);
+    ok &= check("Gray8 canvas", gray);
+
+    std::printf("%s\n", ok ? "all round trips match" : "round trip FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// Command-line batch renderer: parses scene files (see src/bmp_scene.h) and renders them in parallel.
+//
+// Usage: bmp_render [-j threads] [-o output_dir] [-f bmp|qoi] scene_file...
+// Each scene "path/name.scene" is written to "output_dir/name.bmp" (output_dir defaults to ".", -f qoi writes name.qoi).
+// Scenes that fail to parse, would overwrite another scene's output or can't be written are reported, and the
+// exit status is 1 if there were any.
+
+#include "../src/bmp_batch_renderer.h"
+#include "../src/bmp_scene.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Strip directories and extension from a path
+static std::string sceneName(const std::string &path)
+{
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned threads = 0;
+    std::string output_dir = ".";
+    BMPFileFormat format = BMPFileFormat::BMP;
+    std::vector<std::string> scene_files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "-o" && i + 1 < argc)
+        {
+            output_dir = argv[++i];
+        }
+        else if (arg == "-f" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c)
+                           { return static_cast<char>(std::tolower(c)); });
+            if (name != "bmp" && name != "qoi")
+            {
+                std::cerr << "Unknown output format '" << argv[i] << "' (expected bmp or qoi)\n";
+                return 1;
+            }
+            format = name == "qoi" ? BMPFileFormat::QOI : BMPFileFormat::BMP;
+        }
+        else
+        {
+            scene_files.push_back(arg);
+        }
+    }
+
+    if (scene_files.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-o output_dir] [-f bmp|qoi] scene_file...\n";
+        return 1;
+    }
+
+    // Parse everything up front, skipping (and reporting) broken scenes and scenes whose output name is taken
+    std::vector<BMPDrawRecorder> scenes;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, std::string> owners; // output name -> scene that writes it
+    scenes.reserve(scene_files.size());
+    int failed = 0;
+    for (const std::string &path : scene_files)
+    {
+        const std::string name = output_dir + "/" + sceneName(path);
+        auto owner = owners.emplace(name, path);
+        if (!owner.second)
+        {
+            std::cerr << path << ": output " << name << (format == BMPFileFormat::QOI ? ".qoi" : ".bmp")
+                      << " is already written by " << owner.first->second << "\n";
+            ++failed;
+            continue;
+        }
+
+        BMPDrawRecorder recorder(0, 0);
+        std::string error;
+        if (!loadSceneFile(path, recorder, &error))
+        {
+            std::cerr << error << "\n";
+            ++failed;
+            continue;
+        }
+        scenes.push_back(std::move(recorder));
+        names.push_back(name);
+    }
+
+    std::vector<BMPRenderJob> jobs(scenes.size());
+    for (size_t i = 0; i < scenes.size(); ++i)
+    {
+        jobs[i].width = scenes[i].getWidth();
+        jobs[i].height = scenes[i].getHeight();
+        jobs[i].recording = &scenes[i];
+        jobs[i].filename = names[i];
+        jobs[i].format = format;
+    }
+
+    BMPBatchRenderer renderer(threads);
+    BMPBatchStats stats = renderer.run(jobs);
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (stats.job_failed[i])
+        {
+            std::cerr << names[i] << ": " << stats.job_errors[i] << "\n";
+            ++failed;
+        }
+    }
+
+    std::cerr << "Rendered " << jobs.size() - stats.failed_jobs << " images in " << stats.total_milliseconds << " ms ("
+              << stats.images_per_second << " images/s, " << renderer.getThreadCount() << " threads)\n";
+    return failed == 0 ? 0 : 1;
+}